@@ -0,0 +1,91 @@
+
+#include "detailed/decision_tree.hpp"
+
+#include <cassert>
+
+decision_tree::decision_tree(placement_problem const & root_pb, int max_cached) : root(root_pb), cache_size(max_cached){
+    assert(cache_size >= 0);
+    nodes.push_back(tree_node());
+    nodes[0].parent = -1;
+    nodes[0].bound = root.get_cost();
+    nodes[0].open_children = 0;
+    nodes[0].closed = false;
+}
+
+int decision_tree::add_child(int parent, int bound, std::vector<generic_constraint> const & decisions){
+    int n;
+    if(free_nodes.empty()){
+        n = nodes.size();
+        nodes.push_back(tree_node());
+    }
+    else{
+        n = free_nodes.back();
+        free_nodes.pop_back();
+    }
+    tree_node & cur = nodes[n];
+    cur.parent = parent;
+    cur.bound = bound;
+    cur.open_children = 0;
+    cur.closed = false;
+    cur.decisions.assign(decisions.begin(), decisions.end());
+    ++nodes[parent].open_children;
+    return n;
+}
+
+placement_problem decision_tree::get_problem(int n){
+    // Find the nearest ancestor that we can start from
+    std::vector<int> path;
+    int cur = n;
+    while(cur != root_id() and cache_index.count(cur) == 0){
+        path.push_back(cur);
+        cur = nodes[cur].parent;
+    }
+
+    placement_problem ret = root;
+    if(cache_index.count(cur) != 0){
+        auto it = cache_index[cur];
+        ret = it->second;
+        cache.splice(cache.begin(), cache, it);
+    }
+    for(auto it = path.rbegin(); it != path.rend(); ++it){
+        std::vector<generic_constraint> decisions;
+        for(compact_decision const D : nodes[*it].decisions){
+            decisions.push_back(D.get());
+        }
+        ret.apply_decisions(decisions);
+    }
+
+    if(cache_size > 0 and not path.empty()){
+        cache.emplace_front(n, ret);
+        cache_index[n] = cache.begin();
+        if(int(cache.size()) > cache_size){
+            cache_index.erase(cache.back().first);
+            cache.pop_back();
+        }
+    }
+    return ret;
+}
+
+void decision_tree::close(int n){
+    nodes[n].closed = true;
+    if(nodes[n].open_children == 0) release(n);
+}
+
+void decision_tree::release(int n){
+    while(n >= 0){
+        auto it = cache_index.find(n);
+        if(it != cache_index.end()){
+            cache.erase(it->second);
+            cache_index.erase(it);
+        }
+        std::vector<compact_decision>().swap(nodes[n].decisions);
+        free_nodes.push_back(n);
+
+        int parent = nodes[n].parent;
+        if(parent < 0) break;
+        --nodes[parent].open_children;
+        if(nodes[parent].closed and nodes[parent].open_children == 0) n = parent;
+        else break;
+    }
+}
+
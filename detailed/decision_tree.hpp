@@ -0,0 +1,57 @@
+#ifndef AMARANTH_DECISION_TREE_HPP
+#define AMARANTH_DECISION_TREE_HPP
+
+#include "placement_problem.hpp"
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+// Search tree where each node only stores its bound and the decisions taken from its parent
+// The problems are rebuilt by replaying the decisions from the nearest cached ancestor
+class decision_tree{
+    public:
+    typedef placement_problem::generic_constraint generic_constraint;
+
+    private:
+    struct compact_decision{
+        std::int16_t fc, sc;
+        std::int32_t dist_dir; // 2*min_dist + direction
+
+        compact_decision(generic_constraint c) : fc(c.fc), sc(c.sc), dist_dir(2*c.min_dist + (c.direction ? 1 : 0)) {}
+        generic_constraint get() const{ return generic_constraint((dist_dir & 1) != 0, fc, sc, dist_dir >> 1); }
+    };
+
+    struct tree_node{
+        int parent;
+        int bound;
+        int open_children;
+        bool closed; // The node has been evaluated
+        std::vector<compact_decision> decisions;
+    };
+
+    placement_problem root;
+    std::vector<tree_node> nodes;
+    std::vector<int> free_nodes;
+
+    typedef std::list<std::pair<int, placement_problem> > cache_list;
+    int cache_size;
+    cache_list cache; // Most recently used first
+    std::unordered_map<int, cache_list::iterator> cache_index;
+
+    void release(int n);
+
+    public:
+    int root_id() const{ return 0; }
+    int get_bound(int n) const{ return nodes[n].bound; }
+
+    int add_child(int parent, int bound, std::vector<generic_constraint> const & decisions);
+    placement_problem get_problem(int n);
+    // The node has been evaluated; its record is freed once all its children are
+    void close(int n);
+
+    decision_tree(placement_problem const & root_pb, int max_cached);
+};
+
+#endif
+
@@ -1,3 +1,5 @@
+#ifndef AMARANTH_INCREMENTAL_FLOW_HPP
+#define AMARANTH_INCREMENTAL_FLOW_HPP
 
 #include <vector>
 #include <limits>
@@ -11,6 +13,13 @@ class MCF_graph{
 
         edge(int s, int d, int c, int f=0) : source(s), dest(d), cost(c), flow(f) {}
     };
+    // Flow to send from a node to another
+    struct transfer{
+        int source, dest;
+        int amount;
+
+        transfer(int s, int d, int a) : source(s), dest(d), amount(a) {}
+    };
 
     public:
     std::vector<edge> edges;
@@ -37,6 +46,7 @@ class MCF_graph{
     bool check_optimal() const;
     void reorder_edges();
     std::vector<node_elt> get_Bellman_Ford(int source_node) const;
+    std::pair<bool, int> get_cycle_cost(std::vector<node_elt> const & accessibles, int source, int cost) const;
 
     public:
     // Create a graph from an OPTIMAL flow (later maybe add cycle cancelling)
@@ -44,8 +54,20 @@ class MCF_graph{
 
     // Just check the cost of the first cycle
     std::pair<bool, int> try_edge(int source, int dest, int cost) const;
+    // Same for many edges, with one shortest path computation per destination
+    std::vector<std::pair<bool, int> > try_edges(std::vector<edge> const & tentative) const;
     // Add a new edge and get a new optimal flow and potentials for the node; uses Dijkstra instead of Bellman-Ford
     void add_edge(int source, int dest, int cost);
+    // Remove the edge between two nodes, rerouting its flow along shortest paths
+    void remove_edge(int source, int dest);
+    // Send more flow from source to dest along successive shortest paths, keeping the flow optimal
+    void push_flow(int source, int dest, int amount);
+    // Send all the transfers at once, from a flow that is zero everywhere and has no negative cycle
+    // Successive shortest paths, with one Bellman-Ford for the initial potentials and then Dijkstra on the reduced costs
+    void send_transfers(std::vector<transfer> const & transfers);
+    // Insert a node without edges at index n, shifting the following nodes, or remove a node without edges
+    void insert_node(int n);
+    void remove_node(int n);
 
     void selfcheck() const;
 
@@ -57,3 +79,4 @@ class MCF_graph{
     void print() const;
 };
 
+#endif
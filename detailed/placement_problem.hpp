@@ -1,6 +1,10 @@
+#ifndef AMARANTH_PLACEMENT_PROBLEM_HPP
+#define AMARANTH_PLACEMENT_PROBLEM_HPP
 
 #include "incremental_flow.hpp"
 
+#include <memory>
+
 struct point{
     int x, y;
     point(int xi, int yi) : x(xi), y(yi) {}
@@ -22,11 +26,48 @@ struct rect{
     int get_width  () const { return xmax-xmin; };
 };
 
+// Round to a multiple of the pitch, below or above
+int round_lower(int pos, int pitch);
+int round_upper(int pos, int pitch);
+
 struct pin : rect{
     int ind;
     pin(int i, rect r) : rect(r), ind(i) {}
 };
 
+// Flat (CSR) storage of the nets for wirelength evaluation
+// Fixed pins are reduced to one bounding box per net; the offsets of the movable pins are stored as structure of arrays
+class net_hpwl{
+    // The movable pins of net i are [net_limits[i], net_limits[i+1]); the nets of cell c are [cell_limits[c], cell_limits[c+1])
+    std::vector<int> net_limits, cell_limits;
+    std::vector<int> pin_cells, cell_nets;
+    std::vector<int> pin_xmin, pin_ymin, pin_xmax, pin_ymax;
+    // Empty boxes (max_int, min_int) for nets without fixed pins, and a null box for nets without any pin
+    std::vector<int> fixed_xmin, fixed_ymin, fixed_xmax, fixed_ymax;
+
+    int net_cost(int n, int const * x, int const * y) const;
+    void push_net(std::vector<pin> const & n);
+    void replace_pins(int n, std::vector<pin> const & pins);
+    void index_cell_nets();
+
+    public:
+    int cell_count() const{ return cell_limits.size()-1; }
+    int net_count() const{ return net_limits.size()-1; }
+
+    int get_cost(std::vector<point> const & pos) const;
+    // Cost variation when the cells in moved are placed at new_pos instead
+    int get_delta(std::vector<point> const & pos, std::vector<int> const & moved, std::vector<point> const & new_pos) const;
+
+    // Updates that only rewrite the pins of the modified net; the nets have the same indices as in the problem
+    void set_net(int n, std::vector<pin> const & pins);
+    void add_net(std::vector<pin> const & pins);
+    void remove_net(int n);
+    void add_cell();
+    void remove_cell(int c); // The cell must not have any pin left
+
+    net_hpwl(int cell_cnt=0, std::vector<std::vector<pin> > const & nets=std::vector<std::vector<pin> >());
+};
+
 enum branching_rule{
     AREA,
     // Rules based on the minimum displacement necessary on x and y
@@ -56,13 +97,46 @@ class placement_problem{
         bool direction;
         generic_constraint(bool dir, int fst, int snd, int dist) : relative_constraint(fst, snd, dist), direction(dir) {}
     };
+    // A child problem and the constraints added to its parent to obtain it, in order
+    typedef std::pair<placement_problem, std::vector<generic_constraint> > branch_result;
 
     private:
-    MCF_graph x_flow, y_flow; // Flows with 1 fixed node, cell_count() cell nodes and 2*net_count() net nodes, in that order
+    // A net as seen by the flows, after presolve: at most one pin per cell and one fixed pin, weighted by the number of identical nets
+    struct flow_net{
+        int weight;
+        std::vector<pin> pins;
+        flow_net(int w, std::vector<pin> p) : weight(w), pins(p) {}
+    };
+
+    MCF_graph x_flow, y_flow; // Flows with 1 fixed node, cell_count() cell nodes and 2*flow_nets.size() net nodes, in that order
 
+    rect region;
     std::vector<cell> cells;
     std::vector<std::vector<pin> > nets;
     std::vector<rect> fixed_elts;
+    std::shared_ptr<const net_hpwl> wirelength; // Shared by the copies of the problem made while branching
+    net_hpwl & update_wirelength();
+
+    std::vector<flow_net> flow_nets;
+    std::vector<int> net_to_flow_net; // -1 for the nets removed by the presolve
+    int constant_cost; // Cost of the nets removed by the presolve
+
+    std::vector<pin> merge_net_pins(std::vector<pin> const & n) const;
+    void presolve_nets();
+    void detach_net(int i);
+    void attach_net(int i);
+
+    // Row-based windows: all cells have the same height, that is also their vertical pitch
+    // Cells are then assigned to rows, and ordered within each row
+    // The rows start at the bottom of the region, whatever its offset
+    int row_height; // 0 if the window is not row-based
+    bool is_row_aligned(int y) const{ return round_lower(y - region.ymin, row_height) == y - region.ymin; }
+
+    void detect_rows();
+    bool is_row_assigned(int c) const;
+    std::vector<std::vector<generic_constraint> > get_row_decisions(int c) const;
+    std::vector<branch_result> branch_on_row(int c) const;
+    std::vector<branch_result> branch_rows(std::vector<point> const & pos, branching_rule rule) const;
 
     std::vector<rect> position_constraints;
     std::vector<relative_constraint> x_constraints, y_constraints;
@@ -74,17 +148,20 @@ class placement_problem{
     void apply_constraint(generic_constraint constraint);
 
     // Branch with given added constraints, without or with added opposite constraints
-    std::vector<placement_problem> branch_on_constraints(std::vector<generic_constraint> constraints) const;
+    std::vector<branch_result> branch_on_constraints(std::vector<generic_constraint> constraints) const;
 
-    std::vector<placement_problem> branch_overlap_removal(int c1, int c2) const;
-    std::vector<placement_problem> branch_overlap_removal(int c1, rect fixed_elt) const;
+    std::vector<branch_result> branch_overlap_removal(int c1, int c2) const;
+    std::vector<branch_result> branch_overlap_removal(int c1, rect fixed_elt) const;
     std::vector<placement_problem> branch_pitch(int c) const;
 
     std::vector<generic_constraint> get_branching_constraints(int c1, int c2) const;
     std::vector<generic_constraint> get_branching_constraints(int c1, rect fixed) const;
-    std::vector<int> evaluate_branches_expected(std::vector<generic_constraint> constraints) const;
-    std::vector<int> evaluate_branches_strong(std::vector<generic_constraint> constraints) const;
+    // The constraints added by each branch of a branching candidate
+    typedef std::vector<std::vector<generic_constraint> > branching_candidate;
+    // Cost measure (CMIN, CAVG, SMIN or SAVG) for each branching candidate
+    std::vector<int> evaluate_candidates(std::vector<branching_candidate> const & candidates, branching_rule rule) const;
 
+    // Geometric measure of an overlap, -1 if there is none
     int evaluate_branch(int c1, int c2, std::vector<point> const & pos, branching_rule rule = AREA) const;
     int evaluate_branch(int c1, rect fixed, std::vector<point> const & pos, branching_rule rule = AREA) const;
     int evaluate_branch(int c) const;
@@ -94,6 +171,8 @@ class placement_problem{
     public:
     int cell_count() const{ return cells.size(); }
     int net_count() const{ return nets.size(); }
+    int flow_net_count() const{ return flow_nets.size(); }
+    bool is_row_based() const{ return row_height > 0; }
     int fixed_count() const{ return fixed_elts.size(); }
 
     bool operator<(placement_problem const & o) const;
@@ -103,14 +182,29 @@ class placement_problem{
     int get_cost() const;
 
     int get_solution_cost(std::vector<point> const sol) const;
+    int get_solution_delta(std::vector<point> const & sol, std::vector<int> const & moved, std::vector<point> const & new_pos) const;
     bool is_solution_correct(std::vector<point> const sol) const;
 
     void print() const;
 
     std::vector<point> get_positions() const;
     std::vector<placement_problem> branch(branching_rule rule = AREA) const;
+    std::vector<branch_result> branch_with_decisions(branching_rule rule = AREA) const;
+    // Replay decisions obtained from branch_with_decisions
+    void apply_decisions(std::vector<generic_constraint> const & decisions);
+
+    // Modify a root problem in place, keeping its flows optimal, to solve it again after small changes
+    // The previous best positions are a good initial solution, with an entry added or removed for each cell added or removed
+    void set_net(int i, std::vector<pin> const & n);
+    void set_fixed_pin(int net, int pin_ind, rect r);
+    void add_net(std::vector<pin> const & n);
+    void remove_net(int i);
+    int add_cell(cell c);
+    void remove_cell(int c); // Also removes its pins
+    // Check that the updates give the same problem as building it again; no-op with NDEBUG
+    void selfcheck() const;
 
     placement_problem(rect bounding_box, std::vector<cell> icells, std::vector<std::vector<pin> > inets, std::vector<rect> fixed=std::vector<rect>());
 };
 
-
+#endif
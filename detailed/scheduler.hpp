@@ -0,0 +1,47 @@
+#ifndef AMARANTH_SCHEDULER_HPP
+#define AMARANTH_SCHEDULER_HPP
+
+#include "search.hpp"
+#include "window.hpp"
+#include "window_cache.hpp"
+
+#include <istream>
+#include <ostream>
+
+// A complete legal placement, with standard cell rows stacked in a rectangle
+struct design{
+    std::vector<rect> rows;
+    std::vector<cell> cells;
+    std::vector<point> positions;
+    std::vector<bool> fixed;
+    std::vector<std::vector<pin> > nets; // Pins with ind == -1 are fixed terminals
+
+    rect get_region() const;
+    int get_cost() const{ return net_hpwl(cells.size(), nets).get_cost(positions); }
+};
+
+bool read_design(std::istream & is, design & d);
+void write_positions(std::ostream & os, design const & d);
+
+struct scheduler_options{
+    int window_width; // Width of the windows, in the same unit as the positions
+    int window_rows; // Height of the windows, in rows
+    int max_cells; // Windows with more movable cells are skipped
+    int nb_threads;
+    int max_sweeps;
+    search_options search;
+    window_cache * cache; // Optional
+
+    scheduler_options() : window_width(100), window_rows(2), max_cells(10), nb_threads(1), max_sweeps(16), cache(nullptr) {}
+};
+
+struct scheduler_stats{
+    int sweeps, solved_windows, skipped_windows, improved_windows;
+    int initial_cost, final_cost;
+};
+
+// Optimize the windows of a tiling in parallel, commit the improvements and repeat with shifted tilings until no window improves
+scheduler_stats optimize_design(design & d, scheduler_options const & options);
+
+#endif
+
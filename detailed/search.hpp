@@ -0,0 +1,56 @@
+#ifndef AMARANTH_SEARCH_HPP
+#define AMARANTH_SEARCH_HPP
+
+#include "placement_problem.hpp"
+#include "trace.hpp"
+#include "window_cache.hpp"
+
+#include <atomic>
+#include <string>
+
+struct search_options{
+    branching_rule rule;
+    int max_time_ms; // Stop when no better solution has been found for this long
+
+    // Store the open nodes as their decisions from the root, rebuilding the problems on demand
+    bool compact_nodes;
+    int node_cache_size; // Number of problems kept to rebuild the nodes from
+
+    // Shared between concurrent searches on the same problem: best known cost, and signal to stop
+    std::atomic<int> * shared_best_cost;
+    std::atomic<bool> * stop;
+
+    trace_writer * trace; // Optional, records every evaluated node
+
+    search_options(branching_rule r=AREA) : rule(r), max_time_ms(500), compact_nodes(false), node_cache_size(16), shared_best_cost(nullptr), stop(nullptr), trace(nullptr) {}
+};
+
+struct search_result{
+    // O: improved and optimal, U: improved, I: initial solution optimal, F: nothing proved
+    char status;
+    int elapsed_ms;
+    long long nb_evaluated_nodes, nb_bound_pruned, nb_feasibility_pruned;
+    int best_cost;
+    std::vector<point> best_positions;
+    std::vector<std::pair<int, int> > solutions; // Cost and time of each improving solution
+    branching_rule rule; // For a portfolio, the rule that finished first
+    bool cached; // Solution of an identical window taken from a cache, without searching
+};
+
+// Depth-first branch-and-bound from a correct initial solution
+search_result branch_and_bound(placement_problem const & root, std::vector<point> const & initial_pos, search_options const & options);
+
+// Run one search per rule concurrently, sharing the best cost; all stop as soon as one has explored its whole tree
+search_result portfolio_search(placement_problem const & root, std::vector<point> const & initial_pos, std::vector<branching_rule> const & rules, search_options const & options);
+
+// Reuse the solution of an identical window from the cache if it is correct and no worse than the initial one
+// Otherwise search, with a portfolio if rules are given, and record the solution in the cache if it was proved optimal
+search_result solve_with_cache(window const & w, placement_problem const & pl, window_cache * cache, search_options const & options,
+                               std::vector<branching_rule> const & portfolio = std::vector<branching_rule>());
+
+// Names of the rules, as in the enum
+std::string get_rule_name(branching_rule rule);
+bool get_rule_from_name(std::string const & name, branching_rule & rule);
+
+#endif
+
@@ -0,0 +1,62 @@
+#ifndef AMARANTH_TRACE_HPP
+#define AMARANTH_TRACE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <istream>
+#include <fstream>
+
+// Binary trace of a branch-and-bound search: one fixed-size record per evaluated node, in evaluation order
+// The file is a trace_header followed by the records, in the byte order of the machine that wrote it
+
+enum trace_outcome : std::uint8_t{
+    TRACE_BRANCHED,
+    TRACE_SOLUTION,
+    TRACE_BOUND_PRUNED,
+    TRACE_INFEASIBLE
+};
+
+struct trace_header{
+    char magic[4]; // "AMTR"
+    std::uint32_t record_size;
+    std::int32_t initial_cost;
+    std::int32_t rule;
+};
+
+struct trace_record{
+    std::int32_t node, parent; // Ids in creation order; the root is 0 with parent -1
+    std::int32_t bound;
+    std::int32_t time_us; // When the node was evaluated, since the start of the search
+    std::int32_t flow_us; // Spent rebuilding the node and creating its children, mostly in flow updates
+    // First constraint of the decision that created the node from its parent, fc + min_dist <= sc (-1 is the fixed node)
+    std::int16_t fc, sc;
+    std::int32_t min_dist;
+    std::uint8_t direction;
+    std::uint8_t outcome;
+    std::uint16_t nb_decisions; // Constraints in that decision, 0 for the root
+    std::int32_t nb_children;
+};
+static_assert(sizeof(trace_record) == 36, "Trace records should be packed");
+
+// Records are buffered and written by blocks; not shared between concurrent searches
+class trace_writer{
+    std::ofstream os;
+    std::vector<trace_record> buffer;
+
+    public:
+    void write(trace_record const & r){
+        buffer.push_back(r);
+        if(buffer.size() >= 4096) flush();
+    }
+    void flush();
+    bool good() const{ return os.good(); }
+
+    trace_writer(std::string const & filename, int initial_cost, int rule);
+    ~trace_writer(){ flush(); }
+};
+
+bool read_trace(std::istream & is, trace_header & header, std::vector<trace_record> & records);
+
+#endif
+
@@ -0,0 +1,23 @@
+#ifndef AMARANTH_WINDOW_HPP
+#define AMARANTH_WINDOW_HPP
+
+#include "placement_problem.hpp"
+
+#include <istream>
+
+// The input of a placement problem, with an initial solution
+struct window{
+    rect bounding_box;
+    std::vector<cell> cells;
+    std::vector<rect> fixed;
+    std::vector<std::vector<pin> > nets;
+    std::vector<point> positions;
+
+    placement_problem get_problem() const{ return placement_problem(bounding_box, cells, nets, fixed); }
+};
+
+// Read a window in the solver's text format; returns false on a malformed input
+bool read_window(std::istream & is, window & w);
+
+#endif
+
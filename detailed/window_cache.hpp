@@ -0,0 +1,48 @@
+#ifndef AMARANTH_WINDOW_CACHE_HPP
+#define AMARANTH_WINDOW_CACHE_HPP
+
+#include "window.hpp"
+
+#include <string>
+#include <mutex>
+#include <unordered_map>
+
+// Optimal solutions of already solved windows, identified up to translation and cell/net order
+class window_cache{
+    public:
+    struct canonical_form{
+        std::vector<int> key; // Serialized window, translated to the origin with canonical cell and net order
+        std::vector<int> order; // Original index of each canonical cell
+        int dx, dy; // Translation to the origin
+    };
+    // Cells are ordered by color refinement on the netlist; identical windows given in a different order usually get the same form
+    static canonical_form canonicalize(window const & w);
+
+    private:
+    struct key_hash{
+        std::size_t operator()(std::vector<int> const & key) const;
+    };
+    struct entry{
+        int cost;
+        std::vector<point> positions; // In canonical order and coordinates
+    };
+
+    std::unordered_map<std::vector<int>, entry, key_hash> solutions;
+    std::string filename;
+    mutable std::mutex mutex;
+
+    void load();
+
+    public:
+    // Positions of a known optimal solution for the window
+    bool lookup(window const & w, std::vector<point> & positions) const;
+    // Record an optimal solution, and append it to the persistent file if any
+    void insert(window const & w, std::vector<point> const & positions, int cost);
+
+    std::size_t size() const;
+
+    window_cache(std::string const & persistent_file = std::string());
+};
+
+#endif
+
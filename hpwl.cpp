@@ -0,0 +1,174 @@
+
+#include "detailed/placement_problem.hpp"
+
+#include <cassert>
+#include <limits>
+#include <algorithm>
+
+namespace{
+    int const min_int = std::numeric_limits<int>::min();
+    int const max_int = std::numeric_limits<int>::max();
+}
+
+net_hpwl::net_hpwl(int cell_cnt, std::vector<std::vector<pin> > const & nets) : net_limits(1, 0), cell_limits(cell_cnt+1, 0){
+    for(auto const & n : nets) push_net(n);
+    index_cell_nets();
+}
+
+// Append a net, without updating the reverse index
+void net_hpwl::push_net(std::vector<pin> const & n){
+    int fxmin=max_int, fymin=max_int, fxmax=min_int, fymax=min_int;
+    if(n.empty()) fxmin = fymin = fxmax = fymax = 0;
+    for(pin const p : n){
+        assert(p.ind >= -1 and p.ind < cell_count());
+        if(p.ind == -1){
+            fxmin = std::min(fxmin, p.xmin);
+            fymin = std::min(fymin, p.ymin);
+            fxmax = std::max(fxmax, p.xmax);
+            fymax = std::max(fymax, p.ymax);
+        }
+        else{
+            pin_cells.push_back(p.ind);
+            pin_xmin.push_back(p.xmin);
+            pin_ymin.push_back(p.ymin);
+            pin_xmax.push_back(p.xmax);
+            pin_ymax.push_back(p.ymax);
+        }
+    }
+    fixed_xmin.push_back(fxmin);
+    fixed_ymin.push_back(fymin);
+    fixed_xmax.push_back(fxmax);
+    fixed_ymax.push_back(fymax);
+    net_limits.push_back(pin_cells.size());
+}
+
+// Reverse index: the nets of each cell, with a net appearing once per pin
+// A counting sort of the pins, without looking at their offsets
+void net_hpwl::index_cell_nets(){
+    std::fill(cell_limits.begin(), cell_limits.end(), 0);
+    for(int c : pin_cells) ++cell_limits[c+1];
+    for(int c=0; c<cell_count(); ++c) cell_limits[c+1] += cell_limits[c];
+    cell_nets.resize(pin_cells.size());
+    std::vector<int> cur_ind(cell_limits.begin(), cell_limits.end()-1);
+    for(int n=0; n<net_count(); ++n){
+        for(int p=net_limits[n]; p<net_limits[n+1]; ++p){
+            cell_nets[cur_ind[pin_cells[p]]++] = n;
+        }
+    }
+}
+
+// Splice the pins of a net in place of the old ones, without updating the reverse index
+void net_hpwl::replace_pins(int n, std::vector<pin> const & pins){
+    assert(n >= 0 and n < net_count());
+    net_hpwl replacement(cell_count(), std::vector<std::vector<pin> >(1, pins));
+    int begin = net_limits[n], end = net_limits[n+1];
+    for(std::vector<int> net_hpwl::* arr : {&net_hpwl::pin_cells, &net_hpwl::pin_xmin, &net_hpwl::pin_ymin, &net_hpwl::pin_xmax, &net_hpwl::pin_ymax}){
+        std::vector<int> & cur = this->*arr;
+        std::vector<int> const & added = replacement.*arr;
+        cur.erase(cur.begin() + begin, cur.begin() + end);
+        cur.insert(cur.begin() + begin, added.begin(), added.end());
+    }
+    int shift = replacement.pin_cells.size() - (end - begin);
+    for(int i=n+1; i<int(net_limits.size()); ++i) net_limits[i] += shift;
+    fixed_xmin[n] = replacement.fixed_xmin[0];
+    fixed_ymin[n] = replacement.fixed_ymin[0];
+    fixed_xmax[n] = replacement.fixed_xmax[0];
+    fixed_ymax[n] = replacement.fixed_ymax[0];
+}
+
+void net_hpwl::set_net(int n, std::vector<pin> const & pins){
+    replace_pins(n, pins);
+    index_cell_nets();
+}
+
+void net_hpwl::add_net(std::vector<pin> const & pins){
+    push_net(pins);
+    index_cell_nets();
+}
+
+void net_hpwl::remove_net(int n){
+    replace_pins(n, std::vector<pin>());
+    net_limits.erase(net_limits.begin() + n+1);
+    for(std::vector<int> * fixed : {&fixed_xmin, &fixed_ymin, &fixed_xmax, &fixed_ymax}){
+        fixed->erase(fixed->begin() + n);
+    }
+    index_cell_nets();
+}
+
+void net_hpwl::add_cell(){
+    cell_limits.push_back(cell_limits.back());
+}
+
+void net_hpwl::remove_cell(int c){
+    assert(c >= 0 and c < cell_count());
+    assert(cell_limits[c] == cell_limits[c+1]);
+    cell_limits.erase(cell_limits.begin() + c+1);
+    for(int & pc : pin_cells){
+        if(pc > c) --pc;
+    }
+}
+
+// Branch-free on the pins so that the compiler can vectorize it
+int net_hpwl::net_cost(int n, int const * x, int const * y) const{
+    int xmin=fixed_xmin[n], ymin=fixed_ymin[n], xmax=fixed_xmax[n], ymax=fixed_ymax[n];
+    int const * cells = pin_cells.data();
+    int const * pxmin = pin_xmin.data(), * pymin = pin_ymin.data(), * pxmax = pin_xmax.data(), * pymax = pin_ymax.data();
+    for(int p=net_limits[n]; p<net_limits[n+1]; ++p){
+        int px = x[cells[p]], py = y[cells[p]];
+        xmin = std::min(xmin, px + pxmin[p]);
+        ymin = std::min(ymin, py + pymin[p]);
+        xmax = std::max(xmax, px + pxmax[p]);
+        ymax = std::max(ymax, py + pymax[p]);
+    }
+    assert(xmax >= xmin and ymax >= ymin);
+    return (xmax-xmin) + (ymax-ymin);
+}
+
+int net_hpwl::get_cost(std::vector<point> const & pos) const{
+    assert(int(pos.size()) == cell_count());
+    std::vector<int> x(cell_count()), y(cell_count());
+    for(int c=0; c<cell_count(); ++c){
+        x[c] = pos[c].x;
+        y[c] = pos[c].y;
+    }
+    int tot_cost=0;
+    for(int n=0; n<net_count(); ++n){
+        tot_cost += net_cost(n, x.data(), y.data());
+    }
+    return tot_cost;
+}
+
+int net_hpwl::get_delta(std::vector<point> const & pos, std::vector<int> const & moved, std::vector<point> const & new_pos) const{
+    assert(int(pos.size()) == cell_count() and moved.size() == new_pos.size());
+    std::vector<int> touched_nets;
+    for(int c : moved){
+        assert(c >= 0 and c < cell_count());
+        touched_nets.insert(touched_nets.end(), cell_nets.begin()+cell_limits[c], cell_nets.begin()+cell_limits[c+1]);
+    }
+    std::sort(touched_nets.begin(), touched_nets.end());
+    touched_nets.erase(std::unique(touched_nets.begin(), touched_nets.end()), touched_nets.end());
+
+    int delta=0;
+    for(int n : touched_nets){
+        int old_xmin=fixed_xmin[n], old_ymin=fixed_ymin[n], old_xmax=fixed_xmax[n], old_ymax=fixed_ymax[n];
+        int new_xmin=old_xmin, new_ymin=old_ymin, new_xmax=old_xmax, new_ymax=old_ymax;
+        for(int p=net_limits[n]; p<net_limits[n+1]; ++p){
+            int c = pin_cells[p];
+            point old_p = pos[c], new_p = pos[c];
+            for(int i=0; i<int(moved.size()); ++i){
+                if(moved[i] == c) new_p = new_pos[i];
+            }
+            old_xmin = std::min(old_xmin, old_p.x + pin_xmin[p]);
+            old_ymin = std::min(old_ymin, old_p.y + pin_ymin[p]);
+            old_xmax = std::max(old_xmax, old_p.x + pin_xmax[p]);
+            old_ymax = std::max(old_ymax, old_p.y + pin_ymax[p]);
+            new_xmin = std::min(new_xmin, new_p.x + pin_xmin[p]);
+            new_ymin = std::min(new_ymin, new_p.y + pin_ymin[p]);
+            new_xmax = std::max(new_xmax, new_p.x + pin_xmax[p]);
+            new_ymax = std::max(new_ymax, new_p.y + pin_ymax[p]);
+        }
+        delta += (new_xmax-new_xmin) + (new_ymax-new_ymin) - (old_xmax-old_xmin) - (old_ymax-old_ymin);
+    }
+    return delta;
+}
+
@@ -5,6 +5,7 @@
 #include <queue>
 #include <limits>
 #include <iostream>
+#include <algorithm>
 
 namespace{
     int const max_int = std::numeric_limits<int>::max()/2; // Avoid overflows: half the maximum
@@ -65,7 +66,26 @@ void MCF_graph::reorder_edges(){
 }
 
 std::pair<bool, int> MCF_graph::try_edge(int esource, int edestination, int ecost) const{
-    std::vector<node_elt> accessibles = get_Bellman_Ford(edestination);
+    return get_cycle_cost(get_Bellman_Ford(edestination), esource, ecost);
+}
+
+std::vector<std::pair<bool, int> > MCF_graph::try_edges(std::vector<edge> const & tentative) const{
+    std::vector<int> order;
+    for(int i=0; i<tentative.size(); ++i) order.push_back(i);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b){ return tentative[a].dest < tentative[b].dest; });
+
+    std::vector<std::pair<bool, int> > ret(tentative.size());
+    std::vector<node_elt> accessibles;
+    for(int i=0; i<order.size(); ++i){
+        edge const E = tentative[order[i]];
+        if(i == 0 or tentative[order[i-1]].dest != E.dest)
+            accessibles = get_Bellman_Ford(E.dest);
+        ret[order[i]] = get_cycle_cost(accessibles, E.source, E.cost);
+    }
+    return ret;
+}
+
+std::pair<bool, int> MCF_graph::get_cycle_cost(std::vector<node_elt> const & accessibles, int esource, int ecost) const{
     int path_cost = accessibles[esource].cost + ecost;
     int max_flow = accessibles[esource].max_flow;
     if(path_cost < 0){
@@ -147,6 +167,156 @@ void MCF_graph::add_edge(int esource, int edestination, int ecost){
     selfcheck();
 }
 
+void MCF_graph::remove_edge(int esource, int edestination){
+    for(auto it = edges.begin(); it != edges.end(); ++it){
+        if(it->source == esource and it->dest == edestination){
+            int sent_flow = it->flow;
+            cost += it->cost * it->flow;
+            edges.erase(it);
+            // The source now receives more flow than it sends
+            push_flow(esource, edestination, sent_flow);
+            return;
+        }
+    }
+    assert(false);
+}
+
+void MCF_graph::push_flow(int esource, int edestination, int amount){
+    assert(amount >= 0 and esource != edestination);
+    while(amount > 0 and bounded){
+        std::vector<node_elt> accessibles = get_Bellman_Ford(esource);
+        assert(accessibles[esource].cost == 0); // The flow is optimal: no negative cycle
+        int path_cost = accessibles[edestination].cost;
+        assert(path_cost < max_int); // Unreachable nodes are never asked for
+
+        int sent_flow = std::min(amount, accessibles[edestination].max_flow);
+        int cur_node = edestination;
+        while(cur_node != esource){
+            int e = accessibles[cur_node].incoming_edge;
+            assert(e >= 0);
+            if(cur_node == edges[e].dest){
+                edges[e].flow += sent_flow;
+                cur_node = edges[e].source;
+            }else{
+                assert(cur_node == edges[e].source);
+                edges[e].flow -= sent_flow;
+                cur_node = edges[e].dest;
+            }
+        }
+        cost -= sent_flow * path_cost;
+        amount -= sent_flow;
+    }
+    assert(not bounded or check_optimal());
+    selfcheck();
+}
+
+void MCF_graph::send_transfers(std::vector<transfer> const & transfers){
+    assert(cost == 0);
+    // Potentials such that all edges have a nonnegative reduced cost: shortest paths from a virtual source linked to all nodes
+    std::vector<int> potentials(node_count(), 0);
+    for(int i=0; i<=node_count(); ++i){
+        bool found_relaxation = false;
+        for(edge const E : edges){
+            assert(E.flow == 0);
+            if(potentials[E.source] + E.cost < potentials[E.dest]){
+                potentials[E.dest] = potentials[E.source] + E.cost;
+                found_relaxation = true;
+            }
+        }
+        if(not found_relaxation) break;
+        if(i == node_count()){ // Negative cycle
+            bounded = false;
+            return;
+        }
+    }
+
+    std::vector<std::vector<int> > incident(node_count());
+    for(int e=0; e<edges.size(); ++e){
+        incident[edges[e].source].push_back(e);
+        incident[edges[e].dest].push_back(e);
+    }
+
+    for(transfer const T : transfers){
+        int amount = T.amount;
+        while(amount > 0){
+            // Dijkstra on the residual graph with the reduced costs
+            std::vector<node_elt> accessibles(node_count(), node_elt(max_int, -1));
+            std::vector<bool> visited(node_count(), false);
+            typedef std::pair<int, int> dist_node;
+            std::priority_queue<dist_node, std::vector<dist_node>, std::greater<dist_node> > to_visit;
+            accessibles[T.source] = node_elt(0, -1);
+            to_visit.push(dist_node(0, T.source));
+            while(not to_visit.empty()){
+                int n = to_visit.top().second;
+                to_visit.pop();
+                if(visited[n]) continue;
+                visited[n] = true;
+                for(int e : incident[n]){
+                    edge const E = edges[e];
+                    if(E.source == n){
+                        int reduced_cost = accessibles[n].cost + E.cost + potentials[n] - potentials[E.dest];
+                        if(reduced_cost < accessibles[E.dest].cost){
+                            accessibles[E.dest] = node_elt(reduced_cost, e, accessibles[n].max_flow);
+                            to_visit.push(dist_node(reduced_cost, E.dest));
+                        }
+                    }
+                    else if(E.flow > 0){
+                        int reduced_cost = accessibles[n].cost - E.cost + potentials[n] - potentials[E.source];
+                        if(reduced_cost < accessibles[E.source].cost){
+                            accessibles[E.source] = node_elt(reduced_cost, e, std::min(accessibles[n].max_flow, E.flow));
+                            to_visit.push(dist_node(reduced_cost, E.source));
+                        }
+                    }
+                }
+            }
+            int dest_dist = accessibles[T.dest].cost;
+            assert(dest_dist < max_int); // Unreachable nodes are never asked for
+            int path_cost = dest_dist - potentials[T.source] + potentials[T.dest];
+
+            int sent_flow = std::min(amount, accessibles[T.dest].max_flow);
+            int cur_node = T.dest;
+            while(cur_node != T.source){
+                int e = accessibles[cur_node].incoming_edge;
+                if(cur_node == edges[e].dest){
+                    edges[e].flow += sent_flow;
+                    cur_node = edges[e].source;
+                }else{
+                    edges[e].flow -= sent_flow;
+                    cur_node = edges[e].dest;
+                }
+            }
+            cost -= sent_flow * path_cost;
+            amount -= sent_flow;
+
+            // Keep the reduced costs nonnegative on the new residual graph
+            for(int n=0; n<node_count(); ++n){
+                potentials[n] += std::min(accessibles[n].cost, dest_dist);
+            }
+        }
+    }
+    assert(check_optimal());
+    selfcheck();
+}
+
+void MCF_graph::insert_node(int n){
+    assert(n >= 0 and n <= node_count());
+    for(edge & E : edges){
+        if(E.source >= n) ++E.source;
+        if(E.dest >= n) ++E.dest;
+    }
+    ++nb_nodes;
+}
+
+void MCF_graph::remove_node(int n){
+    assert(n >= 0 and n < node_count());
+    for(edge & E : edges){
+        assert(E.source != n and E.dest != n);
+        if(E.source > n) --E.source;
+        if(E.dest > n) --E.dest;
+    }
+    --nb_nodes;
+}
+
 MCF_graph::MCF_graph(int node_cnt, std::vector<MCF_graph::edge> edge_list) : edges(edge_list), nb_nodes(node_cnt), bounded(true), cost(0){
     for(int e=0; e<edges.size(); ++e){
         edge cur = edges[e];
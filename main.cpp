@@ -1,61 +1,60 @@
 
-#include "detailed/placement_problem.hpp"
+#include "detailed/search.hpp"
+#include "detailed/window_cache.hpp"
 
 
 #include <iostream>
-#include <stack>
-#include <limits>
-#include <chrono>
+#include <string>
+#include <sstream>
+#include <cstdlib>
+#include <memory>
 
 const branching_rule rule = BRULE;
 
-std::pair<placement_problem, std::vector<point> > input_placement_problem(){
-    int bxmn, bymn, bxmx, bymx;
-    std::cin >> bxmn >> bymn >> bxmx >> bymx;
-    rect bounding_box(bxmn, bymn, bxmx, bymx);
-
-    int nb_cells, nb_nets, nb_fixeds;
-    std::cin >> nb_cells;
-    std::vector<cell> cells;
-    for(int i=0; i<nb_cells; ++i){
-        int width, height, x_pitch, y_pitch;
-        std::cin >> width >> height >> x_pitch >> y_pitch;
-        cells.emplace_back(width, height, x_pitch, y_pitch);
-    }
-
-    std::cin >> nb_fixeds;
-    std::vector<rect> fixeds;
-    for(int i=0; i<nb_fixeds; ++i){
-        int xmn, ymn, xmx, ymx, ind;
-        std::cin >> xmn >> ymn >> xmx >> ymx;
-        fixeds.emplace_back(xmn, ymn, xmx, ymx);
-    }
+void usage(){
+    std::cerr << "Usage: truc [--compact CACHE_SIZE] [--cache FILE] [--portfolio RULE,RULE,...] [--trace FILE] < window" << std::endl;
+    exit(1);
+}
 
-    std::cin >> nb_nets;
-    std::vector<std::vector<pin> > pins;
-    for(int i=0; i<nb_nets; ++i){
-        pins.emplace_back();
-        int nb_pins;
-        std::cin >> nb_pins;
-        for(int j=0; j<nb_pins; ++j){
-            int xmn, ymn, xmx, ymx, ind;
-            std::cin >> ind >> xmn >> ymn >> xmx >> ymx;
-            pins.back().emplace_back(ind, rect(xmn, ymn, xmx, ymx));
+int main(int argc, char ** argv){
+    search_options options(rule);
+    std::string cache_file, trace_file;
+    std::vector<branching_rule> portfolio;
+    for(int i=1; i<argc; ++i){
+        std::string arg = argv[i];
+        if(arg == "--compact" and i+1 < argc){
+            options.compact_nodes = true;
+            options.node_cache_size = std::atoi(argv[++i]);
+        }
+        else if(arg == "--cache" and i+1 < argc){
+            cache_file = argv[++i];
+        }
+        else if(arg == "--portfolio" and i+1 < argc){
+            std::istringstream names(argv[++i]);
+            std::string name;
+            while(std::getline(names, name, ',')){
+                branching_rule cur;
+                if(not get_rule_from_name(name, cur)) usage();
+                portfolio.push_back(cur);
+            }
+            if(portfolio.empty()) usage();
+        }
+        else if(arg == "--trace" and i+1 < argc){
+            trace_file = argv[++i];
+        }
+        else{
+            usage();
         }
     }
-    std::vector<point> pos;
-    for(int i=0; i<nb_cells; ++i){
-        int x, y;
-        std::cin >> x >> y;
-        pos.emplace_back(x,y);
-    }
-    return std::pair<placement_problem, std::vector<point> >(placement_problem(bounding_box, cells, pins, fixeds), pos);
-}
+    if(not trace_file.empty() and not portfolio.empty()) usage();
 
-int main(){
-    auto input_pl = input_placement_problem();
-    placement_problem first_pl = input_pl.first;
-    std::vector<point> pos = input_pl.second;
+    window input;
+    if(not read_window(std::cin, input)){
+        std::cerr << "Malformed input" << std::endl;
+        abort();
+    }
+    placement_problem first_pl = input.get_problem();
+    std::vector<point> pos = input.positions;
 
     if(not first_pl.is_solution_correct(pos)){
         std::cout << "Wrong initial solution" << std::endl;
@@ -64,75 +63,31 @@ int main(){
     }
     int initial_cost = first_pl.get_solution_cost(pos);
 
-    //std::cout << "Problem with " << first_pl.cell_count() << " cells and " << first_pl.net_count() << " nets " << std::endl;
-    std::stack<placement_problem> to_evaluate;
-    to_evaluate.push(first_pl);
-
-    const int max_time_ms = 500;
-    std::chrono::time_point<std::chrono::system_clock> start, end, last_sol;
-    start = std::chrono::system_clock::now();
-    last_sol = std::chrono::system_clock::now();
-
-    int best_correct_cost = initial_cost;
-    std::vector<std::pair<int, int> > sols;
-
-    long long nb_evaluated_nodes = 0, nb_bound_pruned = 0, nb_feasibility_pruned = 0;
-    while(not to_evaluate.empty()){
-        if(nb_evaluated_nodes % 1000 == 0){
-            std::chrono::time_point<std::chrono::system_clock> cur_time = std::chrono::system_clock::now();
-            int time_to_last_sol = std::chrono::duration_cast<std::chrono::milliseconds>(cur_time-last_sol).count();
-            if(time_to_last_sol > max_time_ms) break;
-        }
-        ++ nb_evaluated_nodes;
-        //if(nb_evaluated_nodes % 1000 == 0) std::cout << "Evaluated " << nb_evaluated_nodes << " nodes" << std::endl;
-
-        placement_problem cur = to_evaluate.top(); to_evaluate.pop();
-        int cur_cost = cur.get_cost();
-        if(cur_cost < best_correct_cost){
-            if(cur.is_correct()){
-                best_correct_cost = cur_cost;
-                // std::cout << "Found new correct solution, of cost " << cur_cost << std::endl;
-                std::chrono::time_point<std::chrono::system_clock> cur_time = std::chrono::system_clock::now();
-                int elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(cur_time-start).count();
-                sols.emplace_back(cur_cost, elapsed_ms);
-                last_sol = std::chrono::system_clock::now();
-            }
-            else if(cur.is_feasible()){
-                std::vector<placement_problem> nexts = cur.branch(rule);
-                for(auto it = nexts.crbegin(); it != nexts.crend(); ++it)
-                    to_evaluate.push(*it);
-            }
-            else{
-                ++nb_feasibility_pruned;
-            }
-        }
-        else{
-            ++nb_bound_pruned;
+    std::unique_ptr<trace_writer> trace;
+    if(not trace_file.empty()){
+        trace.reset(new trace_writer(trace_file, initial_cost, options.rule));
+        if(not trace->good()){
+            std::cerr << "Cannot write the trace to " << trace_file << std::endl;
+            abort();
         }
+        options.trace = trace.get();
     }
 
-    end = std::chrono::system_clock::now();
+    //std::cout << "Problem with " << first_pl.cell_count() << " cells and " << first_pl.net_count() << " nets " << std::endl;
+    std::unique_ptr<window_cache> cache;
+    if(not cache_file.empty()) cache.reset(new window_cache(cache_file));
+    search_result res = solve_with_cache(input, first_pl, cache.get(), options, portfolio);
 
-    int elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end-start).count();
     std::cout << first_pl.cell_count() << "\t" << first_pl.net_count() << "\t" << first_pl.fixed_count() << "\t";
-    if(not sols.empty()){
-        //std::cout << "Found: " << sols.back().second << " ms";
-        if(to_evaluate.empty()) std::cout << "O";
-        else std::cout << "U";
-    }
-    else{
-        if(to_evaluate.empty()) std::cout << "I";
-        else std::cout << "F";
-    }
-    std::cout << "\t" << elapsed_ms << "\t" << nb_evaluated_nodes << "\t" << best_correct_cost << "\t" << initial_cost << std::endl;
-
-// << "\t" << nb_bound_pruned << "\t" << nb_feasibility_pruned << std::endl;
-    //std::cout << "Finished, in " << elapsed_ms << " ms, evaluated " << nb_evaluated_nodes << " nodes" << std::endl;
-    //std::cout << nb_bound_pruned + nb_feasibility_pruned << " were pruned, " << nb_bound_pruned << " for being suboptimal and " << nb_feasibility_pruned << " for being infeasible" << std::endl;
-
-    //std::cout << "Columns:\tTime\tNodes" << std::endl;
-    //std::cout << "Results:\t" <<  elapsed_ms << "\t" << nb_evaluated_nodes << std::endl;
+    std::cout << res.status;
+    std::cout << "\t" << res.elapsed_ms << "\t" << res.nb_evaluated_nodes << "\t" << res.best_cost << "\t" << initial_cost;
+    // No rule solved a window found in the cache
+    if(not portfolio.empty()) std::cout << "\t" << (res.cached ? "-" : get_rule_name(res.rule));
+    std::cout << std::endl;
+
+// << "\t" << res.nb_bound_pruned << "\t" << res.nb_feasibility_pruned << std::endl;
+    //std::cout << "Finished, in " << res.elapsed_ms << " ms, evaluated " << res.nb_evaluated_nodes << " nodes" << std::endl;
+    //std::cout << res.nb_bound_pruned + res.nb_feasibility_pruned << " were pruned, " << res.nb_bound_pruned << " for being suboptimal and " << res.nb_feasibility_pruned << " for being infeasible" << std::endl;
     return 0;
 }
 
-
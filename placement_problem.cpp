@@ -33,34 +33,62 @@ int eval_overlap(rect r1, rect r2, branching_rule rule){
     }
 }
 
-std::vector<int> placement_problem::evaluate_branches_strong(std::vector<generic_constraint> constraints) const{
-    std::vector<int> ret;
-    for(generic_constraint constraint : constraints){
-        if(constraint.direction){
-            auto tmp_flow = y_flow;
-            tmp_flow.add_edge(constraint.sc+1, constraint.fc+1, -constraint.min_dist);
-            if(tmp_flow.is_bounded()) ret.push_back(x_flow.get_cost() + tmp_flow.get_cost());
-        }
-        else{
-            auto tmp_flow = x_flow;
-            tmp_flow.add_edge(constraint.sc+1, constraint.fc+1, -constraint.min_dist);
-            if(tmp_flow.is_bounded()) ret.push_back(y_flow.get_cost() + tmp_flow.get_cost());
+std::vector<int> placement_problem::evaluate_candidates(std::vector<branching_candidate> const & candidates, branching_rule rule) const{
+    assert(rule == CMIN or rule == CAVG or rule == SMIN or rule == SAVG);
+    bool expected = rule == CMIN or rule == CAVG;
+
+    std::vector<std::pair<bool, int> > x_res, y_res;
+    if(expected){
+        // All tentative edges at once: the flows share the shortest path trees between edges with the same destination
+        std::vector<MCF_graph::edge> x_edges, y_edges;
+        for(auto const & candidate : candidates){
+            for(auto const & branch : candidate){
+                for(generic_constraint constraint : branch){
+                    auto & edges = constraint.direction ? y_edges : x_edges;
+                    edges.emplace_back(constraint.sc+1, constraint.fc+1, -constraint.min_dist);
+                }
+            }
         }
+        x_res = x_flow.try_edges(x_edges);
+        y_res = y_flow.try_edges(y_edges);
     }
-    return ret;
-}
-
 
-std::vector<int> placement_problem::evaluate_branches_expected(std::vector<generic_constraint> constraints) const{
     std::vector<int> ret;
-    for(generic_constraint constraint : constraints){
-        if(constraint.direction){
-            auto cur = y_flow.try_edge(constraint.sc+1, constraint.fc+1, -constraint.min_dist);
-            if(cur.first) ret.push_back(x_flow.get_cost() + cur.second);
+    int x_ind=0, y_ind=0;
+    for(auto const & candidate : candidates){
+        std::vector<int> res;
+        for(auto const & branch : candidate){
+            bool feasible = true;
+            int x_cost = x_flow.get_cost(), y_cost = y_flow.get_cost();
+            if(expected){
+                // With several constraints, the cost of the branch is at least the cost of each one
+                for(generic_constraint constraint : branch){
+                    auto cur = constraint.direction ? y_res[y_ind++] : x_res[x_ind++];
+                    int & cost = constraint.direction ? y_cost : x_cost;
+                    feasible = feasible and cur.first;
+                    cost = std::max(cost, cur.second);
+                }
+            }
+            else{
+                for(bool direction : {false, true}){
+                    MCF_graph const & flow = direction ? y_flow : x_flow;
+                    if(std::none_of(branch.begin(), branch.end(), [&](generic_constraint const & c){ return c.direction == direction; })) continue;
+                    MCF_graph tmp_flow = flow;
+                    for(generic_constraint constraint : branch){
+                        if(constraint.direction == direction) tmp_flow.add_edge(constraint.sc+1, constraint.fc+1, -constraint.min_dist);
+                    }
+                    feasible = feasible and tmp_flow.is_bounded();
+                    (direction ? y_cost : x_cost) = tmp_flow.get_cost();
+                }
+            }
+            if(feasible) res.push_back(x_cost + y_cost);
         }
+        if(res.size() <= 1) ret.push_back(std::numeric_limits<int>::max());
+        else if(rule == CMIN or rule == SMIN) ret.push_back(*std::min_element(res.begin(), res.end()));
         else{
-            auto cur = x_flow.try_edge(constraint.sc+1, constraint.fc+1, -constraint.min_dist);
-            if(cur.first) ret.push_back(y_flow.get_cost() + cur.second);
+            int tot=0;
+            for(int t : res) tot += t;
+            ret.push_back(tot/res.size());
         }
     }
     return ret;
@@ -85,55 +113,18 @@ std::vector<placement_problem::generic_constraint> placement_problem::get_branch
 }
 
 int placement_problem::evaluate_branch(int c1, int c2, std::vector<point> const & pos, branching_rule rule) const{
-
     rect fc(pos[c1].x, pos[c1].y, pos[c1].x+cells[c1].width, pos[c1].y+cells[c1].height),
          sc(pos[c2].x, pos[c2].y, pos[c2].x+cells[c2].width, pos[c2].y+cells[c2].height);
     int area = rect::intersection(fc, sc).get_area();
     if(area <= 0) return -1;
-
-    if(rule == CMIN or rule == CAVG
-    or rule == SMIN or rule == SAVG){
-        auto constraints = get_branching_constraints(c1, c2);
-        std::vector<int> res = 
-            (rule == CMIN or rule == CAVG) ?
-            evaluate_branches_expected(constraints)
-          : evaluate_branches_strong(constraints);
-        if(res.size() <= 1) return std::numeric_limits<int>::max();
-        if(rule == SMIN or rule == CMIN) return *std::min_element(res.begin(), res.end());
-        else{
-            int tot=0;
-            for(int t : res) tot += t;
-            return tot/res.size();
-        }
-    }
-    else{
-        return eval_overlap(fc, sc, rule);
-    }
+    return eval_overlap(fc, sc, rule);
 }
 
 int placement_problem::evaluate_branch(int c1, rect fixed, std::vector<point> const & pos, branching_rule rule) const{
     rect crect(pos[c1].x, pos[c1].y, pos[c1].x+cells[c1].width, pos[c1].y+cells[c1].height);
     int area = rect::intersection(fixed, crect).get_area();
     if(area <= 0) return -1;
-
-    if(rule == CMIN or rule == CAVG
-    or rule == SMIN or rule == SAVG){
-        auto constraints = get_branching_constraints(c1, fixed);
-        std::vector<int> res = 
-            (rule == CMIN or rule == CAVG) ?
-            evaluate_branches_expected(constraints)
-          : evaluate_branches_strong(constraints);
-        if(res.size() <= 1) return std::numeric_limits<int>::max();
-        if(rule == SMIN or rule == CMIN) return *std::min_element(res.begin(), res.end());
-        else{
-            int tot=0;
-            for(int t : res) tot += t;
-            return tot/res.size();
-        }
-    }
-    else{
-        return eval_overlap(fixed, crect, rule);
-    }
+    return eval_overlap(fixed, crect, rule);
 }
 
 bool placement_problem::operator<(placement_problem const & o) const{
@@ -154,39 +145,52 @@ void placement_problem::apply_constraint(generic_constraint constraint){
         x_constraints.push_back(constraint);
         x_flow.add_edge(constraint.sc+1, constraint.fc+1, -constraint.min_dist);
     }
+
+    // Constraints with the fixed node bound the position of the cell directly
+    if(constraint.fc == -1 and constraint.sc >= 0){
+        rect & R = position_constraints[constraint.sc];
+        if(constraint.direction) R.ymin = std::max(R.ymin, constraint.min_dist);
+        else                     R.xmin = std::max(R.xmin, constraint.min_dist);
+    }
+    if(constraint.sc == -1 and constraint.fc >= 0){
+        rect & R = position_constraints[constraint.fc];
+        if(constraint.direction) R.ymax = std::min(R.ymax, -constraint.min_dist);
+        else                     R.xmax = std::min(R.xmax, -constraint.min_dist);
+    }
 }
 
-std::vector<placement_problem> placement_problem::branch_on_constraints(std::vector<generic_constraint> constraints) const{
+std::vector<placement_problem::branch_result> placement_problem::branch_on_constraints(std::vector<generic_constraint> constraints) const{
     typedef std::pair<placement_problem::generic_constraint, placement_problem::generic_constraint> cpair;
-    typedef std::pair<placement_problem, placement_problem::generic_constraint> ppair;
+    typedef std::pair<branch_result, placement_problem::generic_constraint> ppair;
 
     std::vector<ppair> probs;
     for(generic_constraint cur : constraints){
         generic_constraint opposite(cur.direction, cur.sc, cur.fc, -cur.min_dist+1);
-        probs.push_back(ppair(*this, opposite));
-        probs.back().first.apply_constraint(cur);
+        probs.push_back(ppair(branch_result(*this, std::vector<generic_constraint>(1, cur)), opposite));
+        probs.back().first.first.apply_constraint(cur);
     }
-    std::sort(probs.begin(), probs.end(), [](ppair const & a, ppair const & b) { return a.first < b.first; });
+    std::sort(probs.begin(), probs.end(), [](ppair const & a, ppair const & b) { return a.first.first < b.first.first; });
     for(int i=0; i+1<probs.size(); ++i){
         for(int j=i+1; j<probs.size(); ++j){
-            probs[j].first.apply_constraint(probs[i].second);
+            probs[j].first.first.apply_constraint(probs[i].second);
+            probs[j].first.second.push_back(probs[i].second);
         }
     }
-    std::vector<placement_problem> ret;
+    std::vector<branch_result> ret;
     for(auto const & cur : probs){
-        if(cur.first.is_feasible())
+        if(cur.first.first.is_feasible())
             ret.push_back(cur.first);
     }
     return ret;
 }
 
 
-std::vector<placement_problem> placement_problem::branch_overlap_removal(int c1, int c2) const{
+std::vector<placement_problem::branch_result> placement_problem::branch_overlap_removal(int c1, int c2) const{
     auto constraints = get_branching_constraints(c1, c2);
     return branch_on_constraints(constraints);
 }
 
-std::vector<placement_problem> placement_problem::branch_overlap_removal(int c1, rect fixed) const{
+std::vector<placement_problem::branch_result> placement_problem::branch_overlap_removal(int c1, rect fixed) const{
     auto constraints = get_branching_constraints(c1, fixed);
     return branch_on_constraints(constraints);
 }
@@ -214,6 +218,12 @@ bool placement_problem::is_solution_correct(std::vector<point> const pos) const{
     }*/
     if(not is_feasible()) return false;
 
+    if(is_row_based()){
+        for(int i=0; i<cells.size(); ++i){
+            if(not is_row_aligned(pos[i].y)) return false;
+        }
+    }
+
     for(rect const R : fixed_elts){
         for(int i=0; i<cells.size(); ++i){
             if(pos[i].x + cells[i].width  > R.xmin
@@ -237,38 +247,18 @@ bool placement_problem::is_solution_correct(std::vector<point> const pos) const{
 }
 
 int placement_problem::get_cost() const{
-    int ret = x_flow.get_cost() + y_flow.get_cost();
+    int ret = x_flow.get_cost() + y_flow.get_cost() + constant_cost;
     if(is_feasible())
         assert(get_solution_cost(get_positions()) == ret);
     return ret;
 }
 
 int placement_problem::get_solution_cost(std::vector<point> const pos) const{
-    int tot_cost=0;
-    for(auto const & n : nets){
-        if(n.empty()) continue;
-        int xmin=std::numeric_limits<int>::max(),
-            ymin=std::numeric_limits<int>::max(),
-            xmax=std::numeric_limits<int>::min(),
-            ymax=std::numeric_limits<int>::min();
-        for(auto const p : n){
-            if(p.ind == -1){
-                xmin = std::min(xmin, p.xmin);
-                xmax = std::max(xmax, p.xmax);
-                ymin = std::min(ymin, p.ymin);
-                ymax = std::max(ymax, p.ymax);
-            }
-            else{
-                xmin = std::min(xmin, pos[p.ind].x + p.xmin);
-                xmax = std::max(xmax, pos[p.ind].x + p.xmax);
-                ymin = std::min(ymin, pos[p.ind].y + p.ymin);
-                ymax = std::max(ymax, pos[p.ind].y + p.ymax);
-            }
-        }
-        assert(xmax >= xmin and ymax >= ymin);
-        tot_cost += ((xmax-xmin) + (ymax-ymin));
-    }
-    return tot_cost;
+    return wirelength->get_cost(pos);
+}
+
+int placement_problem::get_solution_delta(std::vector<point> const & pos, std::vector<int> const & moved, std::vector<point> const & new_pos) const{
+    return wirelength->get_delta(pos, moved, new_pos);
 }
 
 std::vector<point> placement_problem::get_positions() const{
@@ -285,50 +275,94 @@ std::vector<point> placement_problem::get_positions() const{
 }
 
 std::vector<placement_problem> placement_problem::branch(branching_rule rule) const{
+    std::vector<placement_problem> ret;
+    for(branch_result const & child : branch_with_decisions(rule)){
+        ret.push_back(child.first);
+    }
+    return ret;
+}
+
+void placement_problem::apply_decisions(std::vector<generic_constraint> const & decisions){
+    for(generic_constraint const constraint : decisions){
+        apply_constraint(constraint);
+    }
+}
+
+std::vector<placement_problem::branch_result> placement_problem::branch_with_decisions(branching_rule rule) const{
     // Chose a good branch based simply on the positions of the cells
     std::vector<point> pos = get_positions();
+    if(is_row_based()) return branch_rows(pos, rule);
 
-    int best_fc, best_sc;
-    int best_cell_measure=-1;
-    bool found_cell_overlap=false;
+    // With cycle costs, find the overlaps first and evaluate them together
+    bool batched = rule == CMIN or rule == CAVG or rule == SMIN or rule == SAVG;
+    branching_rule overlap_rule = batched ? AREA : rule;
 
-    // Branch to avoid overlaps between cells
+    std::vector<std::pair<int, int> > cell_overlaps;
+    std::vector<int> cell_measures;
     for(int i=0; i+1<cells.size(); ++i){
         for(int j=i+1; j<cells.size(); ++j){
-            int measure = evaluate_branch(i, j, pos, rule);
-            if(measure >= 0 and measure > best_cell_measure){
-                found_cell_overlap=true;
-                best_cell_measure = measure;
-                best_fc = i; best_sc = j;
+            int measure = evaluate_branch(i, j, pos, overlap_rule);
+            if(measure >= 0){
+                cell_overlaps.emplace_back(i, j);
+                cell_measures.push_back(measure);
             }
         }
     }
 
-    rect best_fixed;
-    int best_fixed_c;
-    int best_fixed_measure=-1;
-    bool found_fixed_overlap=false;
-
+    std::vector<std::pair<int, rect> > fixed_overlaps;
+    std::vector<int> fixed_measures;
     for(rect const R : fixed_elts){
         for(int i=0; i<cells.size(); ++i){
-            int measure = evaluate_branch(i, R, pos, rule);
-            if(measure >= 0 and measure > best_fixed_measure){
-                found_fixed_overlap=true;
-                best_fixed_measure = measure;
-                best_fixed = R; best_fixed_c = i;
+            int measure = evaluate_branch(i, R, pos, overlap_rule);
+            if(measure >= 0){
+                fixed_overlaps.emplace_back(i, R);
+                fixed_measures.push_back(measure);
             }
         }
     }
 
+    if(batched){
+        // Each constraint is a branch on its own
+        auto as_candidate = [](std::vector<generic_constraint> const & constraints){
+            branching_candidate ret;
+            for(generic_constraint c : constraints) ret.push_back(std::vector<generic_constraint>(1, c));
+            return ret;
+        };
+        std::vector<branching_candidate> candidates;
+        for(auto const & o : cell_overlaps) candidates.push_back(as_candidate(get_branching_constraints(o.first, o.second)));
+        for(auto const & o : fixed_overlaps) candidates.push_back(as_candidate(get_branching_constraints(o.first, o.second)));
+        std::vector<int> measures = evaluate_candidates(candidates, rule);
+        cell_measures.assign(measures.begin(), measures.begin() + cell_overlaps.size());
+        fixed_measures.assign(measures.begin() + cell_overlaps.size(), measures.end());
+    }
+
+    // Branch to avoid overlaps between cells
+    int best_cell=-1, best_cell_measure=-1;
+    for(int i=0; i<cell_overlaps.size(); ++i){
+        if(cell_measures[i] > best_cell_measure){
+            best_cell_measure = cell_measures[i];
+            best_cell = i;
+        }
+    }
+
+    int best_fixed=-1, best_fixed_measure=-1;
+    for(int i=0; i<fixed_overlaps.size(); ++i){
+        if(fixed_measures[i] > best_fixed_measure){
+            best_fixed_measure = fixed_measures[i];
+            best_fixed = i;
+        }
+    }
+
+    bool found_cell_overlap = best_cell >= 0, found_fixed_overlap = best_fixed >= 0;
     if(found_cell_overlap and (not found_fixed_overlap or best_cell_measure >= best_fixed_measure) ){
-        return branch_overlap_removal(best_fc, best_sc);
+        return branch_overlap_removal(cell_overlaps[best_cell].first, cell_overlaps[best_cell].second);
     }
     else if(found_fixed_overlap){
-        return branch_overlap_removal(best_fixed_c, best_fixed);
+        return branch_overlap_removal(fixed_overlaps[best_fixed].first, fixed_overlaps[best_fixed].second);
     }
     else{
         assert(is_correct());
-        return std::vector<placement_problem>();
+        return std::vector<branch_result>();
     }
 }
 
@@ -336,8 +370,10 @@ std::vector<placement_problem> placement_problem::branch(branching_rule rule) co
 
 placement_problem::placement_problem(rect bounding_box, std::vector<cell> icells, std::vector<std::vector<pin> > inets, std::vector<rect> fixed)
 :
+    region(bounding_box),
     cells(icells),
-    nets(inets)
+    nets(inets),
+    wirelength(std::make_shared<net_hpwl>(icells.size(), inets))
 {
     for(cell const c : cells){
         position_constraints.emplace_back(bounding_box.xmin, bounding_box.ymin, bounding_box.xmax - c.width, bounding_box.ymax - c.height);
@@ -346,45 +382,50 @@ placement_problem::placement_problem(rect bounding_box, std::vector<cell> icells
         if(rect::intersection(R, bounding_box).get_area() > 0)
             fixed_elts.emplace_back(rect::intersection(R, bounding_box));
     }
+    detect_rows();
+
+    presolve_nets();
 
     // The simplest edges: the constraints that a net's upper bound is bigger than a net's lower bound
-    std::vector<MCF_graph::edge> basic_x_edges, basic_y_edges;
-    for(int i=0; i<net_count(); ++i){
+    std::vector<MCF_graph::edge> x_edges, y_edges;
+    std::vector<MCF_graph::transfer> transfers;
+    for(int i=0; i<flow_net_count(); ++i){
         int UB_ind = cell_count() + 1 + 2*i;
         int LB_ind = UB_ind + 1;
-        basic_x_edges.emplace_back(UB_ind, LB_ind, 0, 1);
-        basic_y_edges.emplace_back(UB_ind, LB_ind, 0, 1);
+        x_edges.emplace_back(UB_ind, LB_ind, 0);
+        y_edges.emplace_back(UB_ind, LB_ind, 0);
+        // The weight of the net is the flow from its upper to its lower bound
+        transfers.emplace_back(UB_ind, LB_ind, flow_nets[i].weight);
     }
 
     // Edges for the placement constraints
     for(int i=0; i<cell_count(); ++i){
-        basic_x_edges.emplace_back(i+1, 0, -bounding_box.xmin); // Edge to the fixed node: left limit of the region
-        basic_x_edges.emplace_back(0, i+1, bounding_box.xmax - cells[i].width); // Edge from the fixed node: right limit of the region
-        basic_y_edges.emplace_back(i+1, 0, -bounding_box.ymin); // Edge to the fixed node: lower limit of the region
-        basic_y_edges.emplace_back(0, i+1, bounding_box.ymax - cells[i].height); // Edge from the fixed node: upper limit of the region
+        x_edges.emplace_back(i+1, 0, -bounding_box.xmin); // Edge to the fixed node: left limit of the region
+        x_edges.emplace_back(0, i+1, bounding_box.xmax - cells[i].width); // Edge from the fixed node: right limit of the region
+        y_edges.emplace_back(i+1, 0, -bounding_box.ymin); // Edge to the fixed node: lower limit of the region
+        y_edges.emplace_back(0, i+1, bounding_box.ymax - cells[i].height); // Edge from the fixed node: upper limit of the region
     }
 
-    x_flow = MCF_graph(cell_count() + 2*net_count() + 1, basic_x_edges);
-    y_flow = MCF_graph(cell_count() + 2*net_count() + 1, basic_y_edges);
-    //x_flow.print();
-    //y_flow.print();
-
-    //std::cout << "Net edges" << std::endl;
-    // Edges for the nets
-    for(int i=0; i<net_count(); ++i){
-        assert(not nets[i].empty());
+    // Edges for the nets; presolve leaves at most one pin per cell, so there are no parallel edges
+    for(int i=0; i<flow_net_count(); ++i){
         int UB_ind = cell_count() + 1 + 2*i;
         int LB_ind = UB_ind + 1;
-        for(pin const cur_pin : nets[i]){
-            assert(cur_pin.ind >= -1 and cur_pin.ind < cell_count());
+        for(pin const cur_pin : flow_nets[i].pins){
             // cur_pin.ind == -1 ==> Fixed pin case
-            x_flow.add_edge(UB_ind, cur_pin.ind+1, -cur_pin.xmax);
-            y_flow.add_edge(UB_ind, cur_pin.ind+1, -cur_pin.ymax);
-            x_flow.add_edge(cur_pin.ind+1, LB_ind,  cur_pin.xmin);
-            y_flow.add_edge(cur_pin.ind+1, LB_ind,  cur_pin.ymin);
+            x_edges.emplace_back(UB_ind, cur_pin.ind+1, -cur_pin.xmax);
+            y_edges.emplace_back(UB_ind, cur_pin.ind+1, -cur_pin.ymax);
+            x_edges.emplace_back(cur_pin.ind+1, LB_ind,  cur_pin.xmin);
+            y_edges.emplace_back(cur_pin.ind+1, LB_ind,  cur_pin.ymin);
         }
     }
 
+    // With no flow, only the region edges make cycles, and they are not negative when the cells fit in the region
+    // The optimal flow is then obtained in a single min-cost flow computation rather than edge by edge
+    x_flow = MCF_graph(cell_count() + 2*flow_net_count() + 1, x_edges);
+    y_flow = MCF_graph(cell_count() + 2*flow_net_count() + 1, y_edges);
+    x_flow.send_transfers(transfers);
+    y_flow.send_transfers(transfers);
+
     for(point p : get_positions()){
         assert(p.x != std::numeric_limits<int>::max());
         assert(p.y != std::numeric_limits<int>::max());
@@ -0,0 +1,135 @@
+
+#include "detailed/placement_problem.hpp"
+
+#include <cassert>
+#include <map>
+#include <algorithm>
+
+namespace{
+    rect bounding_union(rect a, rect b){ return rect(std::min(a.xmin, b.xmin), std::min(a.ymin, b.ymin), std::max(a.xmax, b.xmax), std::max(a.ymax, b.ymax)); }
+}
+
+// Pins on the same cell (or fixed pins) only matter through their bounding box
+// Merged pins are sorted by cell index, with the fixed pin first
+std::vector<pin> placement_problem::merge_net_pins(std::vector<pin> const & n) const{
+    std::vector<pin> merged;
+    for(pin const cur_pin : n){
+        assert(cur_pin.ind >= -1 and cur_pin.ind < cell_count());
+        auto it = std::find_if(merged.begin(), merged.end(), [&](pin const & p){ return p.ind == cur_pin.ind; });
+        if(it != merged.end()) *it = pin(cur_pin.ind, bounding_union(*it, cur_pin));
+        else merged.push_back(cur_pin);
+    }
+    std::sort(merged.begin(), merged.end(), [](pin const & a, pin const & b){ return a.ind < b.ind; });
+    return merged;
+}
+
+// Reduce the nets before building the flows, without changing the optimal solutions:
+//   * pins on the same cell (or fixed pins) only matter through their bounding box, and are merged (merge_net_pins)
+//   * nets with a single pin left have a constant cost, and are removed
+//   * identical nets are merged into one net with a bigger weight, that is the flow sent from its upper to its lower bound
+void placement_problem::presolve_nets(){
+    constant_cost = 0;
+    flow_nets.clear();
+    net_to_flow_net.assign(net_count(), -1);
+
+    std::map<std::vector<int>, int> known_nets;
+    for(int i=0; i<net_count(); ++i){
+        std::vector<pin> merged = merge_net_pins(nets[i]);
+        if(merged.size() <= 1){
+            for(pin const p : merged)
+                constant_cost += p.get_width() + p.get_height();
+            continue;
+        }
+
+        std::vector<int> key;
+        for(pin const p : merged){
+            key.insert(key.end(), {p.ind, p.xmin, p.ymin, p.xmax, p.ymax});
+        }
+        auto it = known_nets.find(key);
+        if(it != known_nets.end()){
+            ++flow_nets[it->second].weight;
+            net_to_flow_net[i] = it->second;
+        }
+        else{
+            known_nets.emplace(key, flow_nets.size());
+            net_to_flow_net[i] = flow_nets.size();
+            flow_nets.emplace_back(1, merged);
+        }
+    }
+}
+
+// Remove the contribution of a net from the flows, keeping them optimal
+void placement_problem::detach_net(int i){
+    int f = net_to_flow_net[i];
+    net_to_flow_net[i] = -1;
+    if(f < 0){
+        for(pin const p : merge_net_pins(nets[i]))
+            constant_cost -= p.get_width() + p.get_height();
+        return;
+    }
+
+    int UB_ind = cell_count() + 1 + 2*f;
+    int LB_ind = UB_ind + 1;
+    // Send the flow of this net back: with no supply left, its edges are unused
+    x_flow.push_flow(LB_ind, UB_ind, 1);
+    y_flow.push_flow(LB_ind, UB_ind, 1);
+    if(--flow_nets[f].weight > 0) return;
+
+    for(MCF_graph * flow : {&x_flow, &y_flow}){
+        for(pin const cur_pin : flow_nets[f].pins){
+            flow->remove_edge(UB_ind, cur_pin.ind+1);
+            flow->remove_edge(cur_pin.ind+1, LB_ind);
+        }
+        flow->remove_edge(UB_ind, LB_ind);
+        flow->remove_node(LB_ind);
+        flow->remove_node(UB_ind);
+    }
+    flow_nets.erase(flow_nets.begin() + f);
+    for(int & cur : net_to_flow_net){
+        if(cur > f) --cur;
+    }
+}
+
+// Add the contribution of a net to the flows, keeping them optimal
+void placement_problem::attach_net(int i){
+    assert(net_to_flow_net[i] == -1);
+    std::vector<pin> merged = merge_net_pins(nets[i]);
+    if(merged.size() <= 1){
+        for(pin const p : merged)
+            constant_cost += p.get_width() + p.get_height();
+        return;
+    }
+
+    auto same_pins = [](pin const & a, pin const & b){ return a.ind == b.ind and a.xmin == b.xmin and a.ymin == b.ymin and a.xmax == b.xmax and a.ymax == b.ymax; };
+    int f;
+    for(f=0; f<flow_net_count(); ++f){
+        std::vector<pin> const & cur = flow_nets[f].pins;
+        if(cur.size() == merged.size() and std::equal(cur.begin(), cur.end(), merged.begin(), same_pins)) break;
+    }
+    net_to_flow_net[i] = f;
+
+    int UB_ind = cell_count() + 1 + 2*f;
+    int LB_ind = UB_ind + 1;
+    if(f < flow_net_count()){
+        ++flow_nets[f].weight;
+        x_flow.push_flow(UB_ind, LB_ind, 1);
+        y_flow.push_flow(UB_ind, LB_ind, 1);
+        return;
+    }
+
+    // New nodes at the end of the flows
+    flow_nets.emplace_back(1, merged);
+    for(MCF_graph * flow : {&x_flow, &y_flow}){
+        flow->insert_node(UB_ind);
+        flow->insert_node(LB_ind);
+        flow->add_edge(UB_ind, LB_ind, 0);
+        flow->push_flow(UB_ind, LB_ind, 1);
+    }
+    for(pin const cur_pin : merged){
+        x_flow.add_edge(UB_ind, cur_pin.ind+1, -cur_pin.xmax);
+        y_flow.add_edge(UB_ind, cur_pin.ind+1, -cur_pin.ymax);
+        x_flow.add_edge(cur_pin.ind+1, LB_ind,  cur_pin.xmin);
+        y_flow.add_edge(cur_pin.ind+1, LB_ind,  cur_pin.ymin);
+    }
+}
+
@@ -0,0 +1,176 @@
+
+#include "detailed/placement_problem.hpp"
+
+#include <cassert>
+#include <algorithm>
+
+void placement_problem::detect_rows(){
+    row_height = 0;
+    if(cells.empty()) return;
+    int height = cells[0].height;
+    for(cell const c : cells){
+        if(c.height != height or c.y_pitch != height) return;
+    }
+    // At least one row in the window
+    if(height <= 0 or region.ymin + height > region.ymax) return;
+    row_height = height;
+}
+
+bool placement_problem::is_row_assigned(int c) const{
+    return position_constraints[c].ymin == position_constraints[c].ymax;
+}
+
+// The rows the cell may be placed in, each as the constraints placing it there
+std::vector<std::vector<placement_problem::generic_constraint> > placement_problem::get_row_decisions(int c) const{
+    rect const R = position_constraints[c];
+    std::vector<std::vector<generic_constraint> > ret;
+    for(int y = region.ymin + round_upper(R.ymin - region.ymin, row_height); y <= R.ymax; y += row_height){
+        // Skip the rows where the cell doesn't fit: the flows would only find out after ordering the whole row
+        rect row(region.xmin, y, region.xmax, y + row_height);
+        // Obstacles may overlap: only the union of their extents in x is lost
+        std::vector<std::pair<int, int> > blocked;
+        for(rect const F : fixed_elts){
+            rect inter = rect::intersection(F, row);
+            if(inter.get_area() > 0) blocked.emplace_back(inter.xmin, inter.xmax);
+        }
+        std::sort(blocked.begin(), blocked.end());
+        int free_width = row.get_width();
+        int covered_until = region.xmin;
+        for(auto const & b : blocked){
+            free_width -= std::max(0, b.second - std::max(b.first, covered_until));
+            covered_until = std::max(covered_until, b.second);
+        }
+        for(int i=0; i<cell_count(); ++i){
+            if(i != c and is_row_assigned(i) and position_constraints[i].ymin == y) free_width -= cells[i].width;
+        }
+        if(free_width < cells[c].width) continue;
+
+        ret.push_back(std::vector<generic_constraint>({
+            generic_constraint(true, -1, c,  y), // Above the row
+            generic_constraint(true, c, -1, -y)  // Below the row
+        }));
+    }
+    return ret;
+}
+
+// One child per row the cell may be placed in
+std::vector<placement_problem::branch_result> placement_problem::branch_on_row(int c) const{
+    std::vector<branch_result> ret;
+    for(auto const & decisions : get_row_decisions(c)){
+        placement_problem child = *this;
+        child.apply_decisions(decisions);
+        if(child.is_feasible())
+            ret.push_back(branch_result(child, decisions));
+    }
+    std::sort(ret.begin(), ret.end(), [](branch_result const & a, branch_result const & b){ return a.first < b.first; });
+    return ret;
+}
+
+// Branch on row assignment first; once overlapping cells are in a row, only their order in the row is left to decide
+// The positions in x for a given order are given exactly by the x flow, so there is no need for another 1D algorithm
+std::vector<placement_problem::branch_result> placement_problem::branch_rows(std::vector<point> const & pos, branching_rule rule) const{
+    assert(is_row_based());
+    // The cost rules score the candidates found with the overlaps, as in the generic branching
+    bool cost_rule = rule == CMIN or rule == CAVG or rule == SMIN or rule == SAVG;
+    branching_rule overlap_rule = cost_rule ? AREA : rule;
+
+    std::vector<rect> placed;
+    for(int i=0; i<cell_count(); ++i){
+        placed.emplace_back(pos[i].x, pos[i].y, pos[i].x + cells[i].width, pos[i].y + cells[i].height);
+    }
+
+    // The cell to assign: the most overlapping among those that are not assigned yet
+    std::vector<int> overlaps(cell_count(), 0);
+    for(int i=0; i+1<cell_count(); ++i){
+        for(int j=i+1; j<cell_count(); ++j){
+            int area = rect::intersection(placed[i], placed[j]).get_area();
+            overlaps[i] += area;
+            overlaps[j] += area;
+        }
+    }
+    for(rect const R : fixed_elts){
+        for(int i=0; i<cell_count(); ++i){
+            overlaps[i] += rect::intersection(placed[i], R).get_area();
+        }
+    }
+    std::vector<int> to_assign, assign_measures;
+    for(int i=0; i<cell_count(); ++i){
+        if(is_row_assigned(i)) continue;
+        int measure = overlaps[i] + (is_row_aligned(pos[i].y) ? 0 : 1);
+        if(measure > 0){
+            to_assign.push_back(i);
+            assign_measures.push_back(measure);
+        }
+    }
+    if(cost_rule and not to_assign.empty()){
+        std::vector<branching_candidate> candidates;
+        for(int c : to_assign) candidates.push_back(get_row_decisions(c));
+        assign_measures = evaluate_candidates(candidates, rule);
+    }
+    int best_assign=-1, best_assign_measure=-1;
+    for(int i=0; i<to_assign.size(); ++i){
+        if(assign_measures[i] > best_assign_measure){
+            best_assign_measure = assign_measures[i];
+            best_assign = i;
+        }
+    }
+    if(best_assign >= 0) return branch_on_row(to_assign[best_assign]);
+
+    // All overlapping cells are assigned: the overlaps are in the same row, and are removed by ordering the cells
+    std::vector<std::vector<generic_constraint> > orders;
+    std::vector<int> order_measures;
+    for(int i=0; i+1<cell_count(); ++i){
+        for(int j=i+1; j<cell_count(); ++j){
+            int measure = evaluate_branch(i, j, pos, overlap_rule);
+            if(measure < 0) continue;
+            assert(pos[i].y == pos[j].y);
+            orders.push_back(std::vector<generic_constraint>({
+                generic_constraint(false, i, j, cells[i].width),
+                generic_constraint(false, j, i, cells[j].width)
+            }));
+            order_measures.push_back(measure);
+        }
+    }
+    // Cells first on ties, as in the generic branching
+    int nb_cell_orders = orders.size();
+    for(rect const R : fixed_elts){
+        for(int i=0; i<cell_count(); ++i){
+            int measure = evaluate_branch(i, R, pos, overlap_rule);
+            if(measure < 0) continue;
+            orders.push_back(std::vector<generic_constraint>({
+                generic_constraint(false, i, -1, cells[i].width - R.xmin),
+                generic_constraint(false, -1, i, R.xmax)
+            }));
+            order_measures.push_back(measure);
+        }
+    }
+    if(cost_rule and not orders.empty()){
+        std::vector<branching_candidate> candidates;
+        for(auto const & constraints : orders){
+            branching_candidate cur;
+            for(generic_constraint c : constraints) cur.push_back(std::vector<generic_constraint>(1, c));
+            candidates.push_back(cur);
+        }
+        order_measures = evaluate_candidates(candidates, rule);
+    }
+
+    int best_cell=-1, best_cell_measure=-1, best_fixed=-1, best_fixed_measure=-1;
+    for(int i=0; i<orders.size(); ++i){
+        int & best = i < nb_cell_orders ? best_cell : best_fixed;
+        int & best_measure = i < nb_cell_orders ? best_cell_measure : best_fixed_measure;
+        if(order_measures[i] > best_measure){
+            best_measure = order_measures[i];
+            best = i;
+        }
+    }
+    if(best_cell >= 0 and (best_fixed < 0 or best_cell_measure >= best_fixed_measure)){
+        return branch_on_constraints(orders[best_cell]);
+    }
+    else if(best_fixed >= 0){
+        return branch_on_constraints(orders[best_fixed]);
+    }
+    else{
+        assert(is_correct());
+        return std::vector<branch_result>();
+    }
+}
@@ -0,0 +1,202 @@
+
+#include "detailed/scheduler.hpp"
+
+#include <cassert>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <limits>
+
+rect design::get_region() const{
+    rect ret(std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), std::numeric_limits<int>::min(), std::numeric_limits<int>::min());
+    for(rect const R : rows){
+        ret = rect(std::min(ret.xmin, R.xmin), std::min(ret.ymin, R.ymin), std::max(ret.xmax, R.xmax), std::max(ret.ymax, R.ymax));
+    }
+    return ret;
+}
+
+bool read_design(std::istream & is, design & d){
+    int nb_rows, nb_cells, nb_nets;
+    is >> nb_rows;
+    d.rows.clear();
+    for(int i=0; i<nb_rows and is; ++i){
+        int xmn, ymn, xmx, ymx;
+        is >> xmn >> ymn >> xmx >> ymx;
+        d.rows.emplace_back(xmn, ymn, xmx, ymx);
+    }
+
+    is >> nb_cells;
+    d.cells.clear(); d.positions.clear(); d.fixed.clear();
+    for(int i=0; i<nb_cells and is; ++i){
+        int width, height, x_pitch, y_pitch, x, y, fixed;
+        is >> width >> height >> x_pitch >> y_pitch >> x >> y >> fixed;
+        d.cells.emplace_back(width, height, x_pitch, y_pitch);
+        d.positions.emplace_back(x, y);
+        d.fixed.push_back(fixed != 0);
+    }
+
+    is >> nb_nets;
+    d.nets.clear();
+    for(int i=0; i<nb_nets and is; ++i){
+        d.nets.emplace_back();
+        int nb_pins;
+        is >> nb_pins;
+        for(int j=0; j<nb_pins and is; ++j){
+            int xmn, ymn, xmx, ymx, ind;
+            is >> ind >> xmn >> ymn >> xmx >> ymx;
+            if(ind < -1 or ind >= nb_cells) return false;
+            d.nets.back().emplace_back(ind, rect(xmn, ymn, xmx, ymx));
+        }
+    }
+    return bool(is) and not d.rows.empty();
+}
+
+void write_positions(std::ostream & os, design const & d){
+    for(point p : d.positions){
+        os << p.x << " " << p.y << "\n";
+    }
+    os.flush();
+}
+
+namespace{
+
+struct window_job{
+    window w;
+    std::vector<int> cells; // Index in the design of each cell of the window
+    bool skipped, solved, improved; // Skipped: movable cells, but not a window the solver can handle
+    std::vector<point> new_positions;
+};
+
+rect get_placed(design const & d, int c){
+    return rect(d.positions[c].x, d.positions[c].y, d.positions[c].x + d.cells[c].width, d.positions[c].y + d.cells[c].height);
+}
+
+// The cells entirely in the box are movable; all other cells overlapping it are obstacles, and their pins are fixed
+window_job extract_window(design const & d, rect box, std::vector<std::vector<int> > const & cell_nets){
+    window_job ret;
+    ret.skipped = ret.solved = ret.improved = false;
+    ret.w.bounding_box = box;
+    std::vector<int> local(d.cells.size(), -1);
+    for(int c=0; c<d.cells.size(); ++c){
+        rect R = get_placed(d, c);
+        if(not d.fixed[c] and R.xmin >= box.xmin and R.ymin >= box.ymin and R.xmax <= box.xmax and R.ymax <= box.ymax){
+            local[c] = ret.cells.size();
+            ret.cells.push_back(c);
+            ret.w.cells.push_back(d.cells[c]);
+            ret.w.positions.push_back(d.positions[c]);
+        }
+        else if(rect::intersection(R, box).get_area() > 0){
+            ret.w.fixed.push_back(R);
+        }
+    }
+
+    std::vector<int> window_nets;
+    for(int c : ret.cells) window_nets.insert(window_nets.end(), cell_nets[c].begin(), cell_nets[c].end());
+    std::sort(window_nets.begin(), window_nets.end());
+    window_nets.erase(std::unique(window_nets.begin(), window_nets.end()), window_nets.end());
+    for(int n : window_nets){
+        ret.w.nets.emplace_back();
+        for(pin const p : d.nets[n]){
+            if(p.ind >= 0 and local[p.ind] >= 0)
+                ret.w.nets.back().emplace_back(local[p.ind], p);
+            else if(p.ind >= 0)
+                ret.w.nets.back().emplace_back(-1, rect(p.xmin + d.positions[p.ind].x, p.ymin + d.positions[p.ind].y, p.xmax + d.positions[p.ind].x, p.ymax + d.positions[p.ind].y));
+            else
+                ret.w.nets.back().push_back(p);
+        }
+    }
+    return ret;
+}
+
+// A cell placed on one of the rows of the design, on a site of the row
+bool is_on_row(design const & d, int c, point p){
+    for(rect const R : d.rows){
+        if(p.y == R.ymin and p.x >= R.xmin and p.x + d.cells[c].width <= R.xmax) return (p.x - R.xmin) % d.cells[c].x_pitch == 0;
+    }
+    return false;
+}
+
+void solve_window(window_job & job, scheduler_options const & options){
+    if(job.cells.empty()) return;
+    job.skipped = true;
+    if(int(job.cells.size()) > options.max_cells) return;
+    placement_problem pl = job.w.get_problem();
+    // With cells of several heights, the generic solver would place cells between the rows
+    if(not pl.is_row_based()) return;
+    if(not pl.is_solution_correct(job.w.positions)) return;
+    job.skipped = false;
+    int initial_cost = pl.get_solution_cost(job.w.positions);
+
+    job.new_positions = solve_with_cache(job.w, pl, options.cache, options.search).best_positions;
+    job.solved = true;
+    job.improved = pl.get_solution_cost(job.new_positions) < initial_cost;
+}
+
+}
+
+scheduler_stats optimize_design(design & d, scheduler_options const & options){
+    assert(options.window_width > 0 and options.window_rows > 0 and options.nb_threads > 0);
+    net_hpwl wirelength(d.cells.size(), d.nets);
+    std::vector<std::vector<int> > cell_nets(d.cells.size());
+    for(int n=0; n<d.nets.size(); ++n){
+        for(pin const p : d.nets[n]){
+            if(p.ind >= 0) cell_nets[p.ind].push_back(n);
+        }
+    }
+
+    rect region = d.get_region();
+    int row_height = d.rows[0].get_height();
+    int window_height = options.window_rows * row_height;
+
+    scheduler_stats stats;
+    stats.sweeps = 0; stats.solved_windows = 0; stats.skipped_windows = 0; stats.improved_windows = 0;
+    stats.initial_cost = wirelength.get_cost(d.positions);
+
+    // Four tilings, shifted by half a window in x and/or y, so that the windows of successive sweeps overlap
+    int sweeps_without_improvement = 0;
+    while(stats.sweeps < options.max_sweeps and sweeps_without_improvement < 4){
+        int shift_x = (stats.sweeps % 2) * (options.window_width / 2);
+        int shift_y = ((stats.sweeps / 2) % 2) * (options.window_rows / 2) * row_height;
+        ++stats.sweeps;
+
+        std::vector<window_job> jobs;
+        for(int y = region.ymin + shift_y - (shift_y > 0 ? window_height : 0); y < region.ymax; y += window_height){
+            for(int x = region.xmin + shift_x - (shift_x > 0 ? options.window_width : 0); x < region.xmax; x += options.window_width){
+                rect box = rect::intersection(rect(x, y, x + options.window_width, y + window_height), region);
+                if(box.get_area() > 0) jobs.push_back(extract_window(d, box, cell_nets));
+            }
+        }
+
+        // The windows of a tiling are disjoint: they are solved independently
+        std::atomic<int> next_job(0);
+        std::vector<std::thread> workers;
+        for(int t=0; t<options.nb_threads; ++t){
+            workers.emplace_back([&](){
+                for(int j = next_job++; j < jobs.size(); j = next_job++)
+                    solve_window(jobs[j], options);
+            });
+        }
+        for(std::thread & t : workers) t.join();
+
+        // Neighbouring windows moved meanwhile: commit only what still improves the whole design
+        bool improved = false;
+        for(window_job const & job : jobs){
+            if(job.solved) ++stats.solved_windows;
+            if(job.skipped) ++stats.skipped_windows;
+            if(not job.improved) continue;
+            // The solver ignores the pitches in x: solutions off the sites are not committed
+            bool legal = true;
+            for(int i=0; i<job.cells.size(); ++i) legal = legal and is_on_row(d, job.cells[i], job.new_positions[i]);
+            if(legal and wirelength.get_delta(d.positions, job.cells, job.new_positions) < 0){
+                for(int i=0; i<job.cells.size(); ++i) d.positions[job.cells[i]] = job.new_positions[i];
+                ++stats.improved_windows;
+                improved = true;
+            }
+        }
+        sweeps_without_improvement = improved ? 0 : sweeps_without_improvement + 1;
+    }
+
+    stats.final_cost = wirelength.get_cost(d.positions);
+    return stats;
+}
+
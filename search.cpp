@@ -0,0 +1,298 @@
+
+#include "detailed/search.hpp"
+#include "detailed/decision_tree.hpp"
+
+#include <cassert>
+#include <algorithm>
+#include <stack>
+#include <chrono>
+#include <thread>
+#include <cstring>
+
+namespace{
+
+typedef placement_problem::branch_result branch_result;
+
+// Open nodes stored as complete problems
+class problem_frontier{
+    std::stack<std::pair<int, placement_problem> > to_evaluate;
+
+    public:
+    bool empty() const{ return to_evaluate.empty(); }
+    int top_bound() const{ return to_evaluate.top().first; }
+    void prune(){ to_evaluate.pop(); }
+    placement_problem pop_problem(){
+        placement_problem ret = to_evaluate.top().second;
+        to_evaluate.pop();
+        return ret;
+    }
+    void push_children(std::vector<branch_result> const & children){
+        for(auto it = children.crbegin(); it != children.crend(); ++it)
+            to_evaluate.push(std::make_pair(it->first.get_cost(), it->first));
+    }
+    void close_current(){}
+
+    problem_frontier(placement_problem const & root){ to_evaluate.push(std::make_pair(root.get_cost(), root)); }
+};
+
+// Open nodes stored as decisions from the root
+class compact_frontier{
+    decision_tree tree;
+    std::stack<int> to_evaluate;
+    int current;
+
+    public:
+    bool empty() const{ return to_evaluate.empty(); }
+    int top_bound() const{ return tree.get_bound(to_evaluate.top()); }
+    void prune(){
+        tree.close(to_evaluate.top());
+        to_evaluate.pop();
+    }
+    placement_problem pop_problem(){
+        current = to_evaluate.top();
+        to_evaluate.pop();
+        return tree.get_problem(current);
+    }
+    void push_children(std::vector<branch_result> const & children){
+        for(auto it = children.crbegin(); it != children.crend(); ++it)
+            to_evaluate.push(tree.add_child(current, it->first.get_cost(), it->second));
+    }
+    void close_current(){ tree.close(current); }
+
+    compact_frontier(placement_problem const & root, int cache_size) : tree(root, cache_size), current(-1){ to_evaluate.push(tree.root_id()); }
+};
+
+// Follows the frontier to give an id to each node, and writes a record when it is evaluated
+class search_tracer{
+    trace_writer * writer;
+    std::stack<trace_record> open; // Same order as the frontier
+    int next_id;
+    std::chrono::steady_clock::time_point start;
+
+    public:
+    // Complete the record of the node just taken from the frontier, and return its id
+    int close(int bound, trace_outcome outcome, int flow_us, int nb_children){
+        if(writer == nullptr) return -1;
+        trace_record r = open.top();
+        open.pop();
+        r.bound = bound;
+        r.time_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        r.flow_us = flow_us;
+        r.outcome = outcome;
+        r.nb_children = nb_children;
+        writer->write(r);
+        return r.node;
+    }
+    void push_children(int parent, std::vector<branch_result> const & children){
+        if(writer == nullptr) return;
+        std::vector<int> ids;
+        for(int i=0; i<children.size(); ++i) ids.push_back(next_id++);
+        for(int i=children.size()-1; i>=0; --i){
+            std::vector<placement_problem::generic_constraint> const & decisions = children[i].second;
+            trace_record r;
+            std::memset(&r, 0, sizeof(r));
+            r.node = ids[i];
+            r.parent = parent;
+            if(not decisions.empty()){
+                r.fc = decisions[0].fc;
+                r.sc = decisions[0].sc;
+                r.min_dist = decisions[0].min_dist;
+                r.direction = decisions[0].direction;
+            }
+            r.nb_decisions = decisions.size();
+            open.push(r);
+        }
+    }
+
+    search_tracer(trace_writer * w) : writer(w), next_id(1), start(std::chrono::steady_clock::now()){
+        trace_record root;
+        std::memset(&root, 0, sizeof(root));
+        root.parent = -1;
+        root.fc = root.sc = -1;
+        open.push(root);
+    }
+};
+
+template<class frontier>
+search_result run_search(frontier & to_evaluate, std::vector<point> const & initial_pos, int initial_cost, search_options const & options){
+    std::chrono::time_point<std::chrono::system_clock> start, end, last_sol;
+    start = std::chrono::system_clock::now();
+    last_sol = std::chrono::system_clock::now();
+
+    search_result res;
+    res.best_cost = initial_cost;
+    res.best_positions = initial_pos;
+    res.nb_evaluated_nodes = 0; res.nb_bound_pruned = 0; res.nb_feasibility_pruned = 0;
+    res.rule = options.rule;
+    res.cached = false;
+    int shared_cost = initial_cost;
+    search_tracer tracer(options.trace);
+
+    while(not to_evaluate.empty()){
+        if(options.stop != nullptr and options.stop->load(std::memory_order_relaxed)) break;
+        if(options.shared_best_cost != nullptr){
+            // Improvements by the other searches count as progress
+            int cur_shared = options.shared_best_cost->load(std::memory_order_relaxed);
+            if(cur_shared < shared_cost){
+                shared_cost = cur_shared;
+                last_sol = std::chrono::system_clock::now();
+            }
+        }
+        if(res.nb_evaluated_nodes % 1000 == 0){
+            std::chrono::time_point<std::chrono::system_clock> cur_time = std::chrono::system_clock::now();
+            int time_to_last_sol = std::chrono::duration_cast<std::chrono::milliseconds>(cur_time-last_sol).count();
+            if(time_to_last_sol > options.max_time_ms) break;
+        }
+        ++ res.nb_evaluated_nodes;
+
+        // The bound is known without rebuilding the node
+        if(to_evaluate.top_bound() >= std::min(res.best_cost, shared_cost)){
+            tracer.close(to_evaluate.top_bound(), TRACE_BOUND_PRUNED, 0, 0);
+            to_evaluate.prune();
+            ++res.nb_bound_pruned;
+            continue;
+        }
+
+        std::chrono::steady_clock::time_point flow_start = std::chrono::steady_clock::now();
+        auto flow_us = [&](){ return int(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - flow_start).count()); };
+        placement_problem cur = to_evaluate.pop_problem();
+        if(cur.is_correct()){
+            tracer.close(cur.get_cost(), TRACE_SOLUTION, flow_us(), 0);
+            res.best_cost = cur.get_cost();
+            res.best_positions = cur.get_positions();
+            std::chrono::time_point<std::chrono::system_clock> cur_time = std::chrono::system_clock::now();
+            int elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(cur_time-start).count();
+            res.solutions.emplace_back(res.best_cost, elapsed_ms);
+            last_sol = std::chrono::system_clock::now();
+            if(options.shared_best_cost != nullptr){
+                int expected = options.shared_best_cost->load();
+                while(res.best_cost < expected and not options.shared_best_cost->compare_exchange_weak(expected, res.best_cost));
+            }
+        }
+        else if(cur.is_feasible()){
+            std::vector<branch_result> children = cur.branch_with_decisions(options.rule);
+            tracer.push_children(tracer.close(cur.get_cost(), TRACE_BRANCHED, flow_us(), children.size()), children);
+            to_evaluate.push_children(children);
+        }
+        else{
+            tracer.close(cur.get_cost(), TRACE_INFEASIBLE, flow_us(), 0);
+            ++res.nb_feasibility_pruned;
+        }
+        to_evaluate.close_current();
+    }
+
+    if(to_evaluate.empty() and options.stop != nullptr) options.stop->store(true);
+
+    end = std::chrono::system_clock::now();
+    res.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end-start).count();
+    if(not res.solutions.empty()){
+        res.status = to_evaluate.empty() ? 'O' : 'U';
+    }
+    else{
+        res.status = to_evaluate.empty() ? 'I' : 'F';
+    }
+    return res;
+}
+
+}
+
+search_result branch_and_bound(placement_problem const & root, std::vector<point> const & initial_pos, search_options const & options){
+    int initial_cost = root.get_solution_cost(initial_pos);
+    if(options.compact_nodes){
+        compact_frontier to_evaluate(root, options.node_cache_size);
+        return run_search(to_evaluate, initial_pos, initial_cost, options);
+    }
+    else{
+        problem_frontier to_evaluate(root);
+        return run_search(to_evaluate, initial_pos, initial_cost, options);
+    }
+}
+
+search_result portfolio_search(placement_problem const & root, std::vector<point> const & initial_pos, std::vector<branching_rule> const & rules, search_options const & options){
+    assert(not rules.empty());
+    int initial_cost = root.get_solution_cost(initial_pos);
+    std::atomic<int> best_cost(initial_cost);
+    std::atomic<bool> stop(false);
+    std::atomic<int> winner(-1);
+
+    std::vector<search_result> results(rules.size());
+    std::vector<std::thread> threads;
+    for(int i=0; i<rules.size(); ++i){
+        threads.emplace_back([&, i](){
+            search_options cur_options = options;
+            cur_options.rule = rules[i];
+            cur_options.shared_best_cost = &best_cost;
+            cur_options.stop = &stop;
+            cur_options.trace = nullptr; // A trace follows a single search
+            results[i] = branch_and_bound(root, initial_pos, cur_options);
+            bool finished = results[i].status == 'O' or results[i].status == 'I';
+            int none = -1;
+            if(finished) winner.compare_exchange_strong(none, i);
+        });
+    }
+    for(std::thread & t : threads) t.join();
+
+    // Without a proof, report the rule that found the best solution
+    int win = winner.load();
+    if(win < 0){
+        win = 0;
+        for(int i=1; i<rules.size(); ++i){
+            if(results[i].best_cost < results[win].best_cost) win = i;
+        }
+    }
+    search_result ret = results[win];
+    for(int i=0; i<rules.size(); ++i){
+        if(results[i].best_cost < ret.best_cost){
+            ret.best_cost = results[i].best_cost;
+            ret.best_positions = results[i].best_positions;
+        }
+        if(i != win){
+            ret.nb_evaluated_nodes += results[i].nb_evaluated_nodes;
+            ret.nb_bound_pruned += results[i].nb_bound_pruned;
+            ret.nb_feasibility_pruned += results[i].nb_feasibility_pruned;
+        }
+    }
+    bool improved = ret.best_cost < initial_cost;
+    bool proved = winner.load() >= 0;
+    ret.status = improved ? (proved ? 'O' : 'U') : (proved ? 'I' : 'F');
+    return ret;
+}
+
+search_result solve_with_cache(window const & w, placement_problem const & pl, window_cache * cache, search_options const & options, std::vector<branching_rule> const & portfolio){
+    int initial_cost = pl.get_solution_cost(w.positions);
+    std::vector<point> cached_pos;
+    if(cache != nullptr and cache->lookup(w, cached_pos) and pl.is_solution_correct(cached_pos) and pl.get_solution_cost(cached_pos) <= initial_cost){
+        search_result res;
+        res.best_cost = pl.get_solution_cost(cached_pos);
+        res.best_positions = cached_pos;
+        res.status = res.best_cost < initial_cost ? 'O' : 'I';
+        res.elapsed_ms = 0;
+        res.nb_evaluated_nodes = 0; res.nb_bound_pruned = 0; res.nb_feasibility_pruned = 0;
+        res.rule = options.rule;
+        res.cached = true;
+        return res;
+    }
+
+    search_result res = portfolio.empty() ? branch_and_bound(pl, w.positions, options) : portfolio_search(pl, w.positions, portfolio, options);
+    if(cache != nullptr and (res.status == 'O' or res.status == 'I'))
+        cache->insert(w, res.best_positions, res.best_cost);
+    return res;
+}
+
+namespace{
+    char const * rule_names[] = {"AREA", "LMIN", "LMAX", "LAVG", "WMIN", "WMAX", "WAVG", "CMIN", "CAVG", "SMIN", "SAVG"};
+}
+
+std::string get_rule_name(branching_rule rule){
+    return rule_names[rule];
+}
+
+bool get_rule_from_name(std::string const & name, branching_rule & rule){
+    for(int i=0; i<=SAVG; ++i){
+        if(name == rule_names[i]){
+            rule = static_cast<branching_rule>(i);
+            return true;
+        }
+    }
+    return false;
+}
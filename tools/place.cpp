@@ -0,0 +1,48 @@
+
+#include "detailed/scheduler.hpp"
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <memory>
+
+void usage(){
+    std::cerr << "Usage: place [--threads N] [--width W] [--rows R] [--max-cells N] [--rule RULE] [--time MS] [--cache FILE] < design > positions" << std::endl;
+    exit(1);
+}
+
+int main(int argc, char ** argv){
+    scheduler_options options;
+    std::unique_ptr<window_cache> cache;
+    for(int i=1; i<argc; ++i){
+        std::string arg = argv[i];
+        if(i+1 >= argc) usage();
+        std::string val = argv[++i];
+        if(arg == "--threads") options.nb_threads = std::atoi(val.c_str());
+        else if(arg == "--width") options.window_width = std::atoi(val.c_str());
+        else if(arg == "--rows") options.window_rows = std::atoi(val.c_str());
+        else if(arg == "--max-cells") options.max_cells = std::atoi(val.c_str());
+        else if(arg == "--time") options.search.max_time_ms = std::atoi(val.c_str());
+        else if(arg == "--rule"){
+            if(not get_rule_from_name(val, options.search.rule)) usage();
+        }
+        else if(arg == "--cache"){
+            cache.reset(new window_cache(val));
+            options.cache = cache.get();
+        }
+        else usage();
+    }
+    if(options.nb_threads <= 0 or options.window_width <= 0 or options.window_rows <= 0) usage();
+
+    design d;
+    if(not read_design(std::cin, d)){
+        std::cerr << "Malformed design" << std::endl;
+        abort();
+    }
+    scheduler_stats stats = optimize_design(d, options);
+    write_positions(std::cout, d);
+    std::cerr << "Sweeps: " << stats.sweeps << "\tWindows: " << stats.solved_windows << "\tSkipped: " << stats.skipped_windows << "\tImproved: " << stats.improved_windows
+              << "\tCost: " << stats.initial_cost << " -> " << stats.final_cost << std::endl;
+    return 0;
+}
+
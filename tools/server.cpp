@@ -0,0 +1,361 @@
+
+#include "detailed/search.hpp"
+#include "detailed/window.hpp"
+#include "detailed/window_cache.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <memory>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Solver daemon on a Unix domain socket
+// Requests, one per line, answered in completion order:
+//   SOLVE <id> <deadline_ms> <nb_bytes>, followed by the window in the solver's text format
+//       -> RESULT <id> <status> <elapsed_ms> <nodes> <best_cost> <initial_cost> <x y for each cell>
+//          with the solver's status, or C (cancelled), T (deadline passed while queued), E (malformed window)
+//   CANCEL <id>
+//   STATS  -> STATS <queued> <running> <completed> <p50_ms> <p90_ms> <p99_ms>
+
+typedef std::chrono::steady_clock server_clock;
+
+void set_nonblocking(int fd){
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+// The socket is non-blocking and only the poll thread reads and writes it
+// Other threads queue their lines in the output buffer and wake the poll thread up
+struct connection{
+    int fd, wake_fd;
+    std::mutex write_mutex;
+    bool closed;
+    std::string input, output;
+
+    void send_line(std::string const & line){
+        {
+            std::lock_guard<std::mutex> lock(write_mutex);
+            if(closed) return;
+            output += line;
+            output += '\n';
+        }
+        // A full pipe already has a pending wake up
+        ssize_t res = write(wake_fd, "w", 1);
+        (void) res;
+    }
+
+    bool has_output(){
+        std::lock_guard<std::mutex> lock(write_mutex);
+        return not output.empty();
+    }
+
+    // Send what the socket accepts without blocking; false if the connection is lost
+    bool flush(){
+        std::lock_guard<std::mutex> lock(write_mutex);
+        std::size_t sent = 0;
+        while(sent < output.size()){
+            ssize_t cur = send(fd, output.data() + sent, output.size() - sent, MSG_NOSIGNAL);
+            if(cur > 0) sent += cur;
+            else if(cur < 0 and errno == EINTR) continue;
+            else if(cur < 0 and (errno == EAGAIN or errno == EWOULDBLOCK)) break;
+            else return false;
+        }
+        output.erase(0, sent);
+        return true;
+    }
+
+    connection(int f, int w) : fd(f), wake_fd(w), closed(false) {}
+};
+
+struct request{
+    std::string id;
+    std::shared_ptr<connection> conn;
+    std::string payload;
+    server_clock::time_point arrival, deadline;
+    std::atomic<bool> stop, cancelled;
+
+    request() : stop(false), cancelled(false) {}
+};
+
+class solver_server{
+    search_options options;
+    window_cache * cache;
+
+    std::mutex mutex;
+    std::condition_variable has_requests;
+    std::deque<std::shared_ptr<request> > queue;
+    std::list<std::shared_ptr<request> > pending; // Queued or running
+    int running;
+    long long completed;
+    std::deque<int> latencies; // Of the last completed requests, in ms
+
+    std::string solve(request & req);
+    void work();
+    void handle_input(std::shared_ptr<connection> const & conn);
+
+    public:
+    void run(int listen_fd, int nb_threads);
+
+    solver_server(search_options opt, window_cache * c) : options(opt), cache(c), running(0), completed(0) {}
+};
+
+std::string solver_server::solve(request & req){
+    std::ostringstream res;
+    res << "RESULT " << req.id << " ";
+    if(req.stop){
+        res << (req.cancelled ? "C" : "T");
+        return res.str();
+    }
+
+    std::istringstream is(req.payload);
+    window w;
+    if(not read_window(is, w)){
+        res << "E";
+        return res.str();
+    }
+    placement_problem pl = w.get_problem();
+    if(not pl.is_solution_correct(w.positions)){
+        res << "E";
+        return res.str();
+    }
+
+    int initial_cost = pl.get_solution_cost(w.positions);
+    search_options cur_options = options;
+    cur_options.stop = &req.stop;
+    search_result sr = solve_with_cache(w, pl, cache, cur_options);
+
+    char status = req.cancelled ? 'C' : sr.status;
+    res << status << " " << sr.elapsed_ms << " " << sr.nb_evaluated_nodes << " " << sr.best_cost << " " << initial_cost;
+    for(point p : sr.best_positions) res << " " << p.x << " " << p.y;
+    return res.str();
+}
+
+void solver_server::work(){
+    while(true){
+        std::shared_ptr<request> req;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            has_requests.wait(lock, [&](){ return not queue.empty(); });
+            req = queue.front();
+            queue.pop_front();
+            ++running;
+        }
+
+        std::string res = solve(*req);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --running;
+            ++completed;
+            pending.remove(req);
+            latencies.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(server_clock::now() - req->arrival).count());
+            if(latencies.size() > 10000) latencies.pop_front();
+        }
+        req->conn->send_line(res);
+    }
+}
+
+void solver_server::handle_input(std::shared_ptr<connection> const & conn){
+    std::string & input = conn->input;
+    while(true){
+        std::size_t line_end = input.find('\n');
+        if(line_end == std::string::npos) return;
+        std::istringstream line(input.substr(0, line_end));
+        std::string command;
+        line >> command;
+
+        if(command == "SOLVE"){
+            std::shared_ptr<request> req(new request());
+            int deadline_ms;
+            std::size_t nb_bytes;
+            if(not (line >> req->id >> deadline_ms >> nb_bytes)){
+                conn->send_line("ERROR malformed SOLVE");
+                input.erase(0, line_end+1);
+                continue;
+            }
+            if(input.size() < line_end + 1 + nb_bytes) return; // Wait for the whole window
+            req->conn = conn;
+            req->payload = input.substr(line_end+1, nb_bytes);
+            req->arrival = server_clock::now();
+            req->deadline = req->arrival + std::chrono::milliseconds(deadline_ms);
+            input.erase(0, line_end + 1 + nb_bytes);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(req);
+            pending.push_back(req);
+            has_requests.notify_one();
+            continue;
+        }
+
+        input.erase(0, line_end+1);
+        if(command == "CANCEL"){
+            std::string id;
+            line >> id;
+            std::lock_guard<std::mutex> lock(mutex);
+            for(auto const & req : pending){
+                if(req->conn == conn and req->id == id){
+                    req->cancelled = true;
+                    req->stop = true;
+                }
+            }
+        }
+        else if(command == "STATS"){
+            std::ostringstream res;
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<int> sorted(latencies.begin(), latencies.end());
+            std::sort(sorted.begin(), sorted.end());
+            auto percentile = [&](int p){ return sorted.empty() ? 0 : sorted[(sorted.size()-1) * p / 100]; };
+            res << "STATS " << queue.size() << " " << running << " " << completed << " " << percentile(50) << " " << percentile(90) << " " << percentile(99);
+            conn->send_line(res.str());
+        }
+        else if(not command.empty()){
+            conn->send_line("ERROR unknown command " + command);
+        }
+    }
+}
+
+void solver_server::run(int listen_fd, int nb_threads){
+    // Written by the threads that queue output, to interrupt the poll
+    int wake_pipe[2];
+    if(pipe(wake_pipe) != 0){
+        std::cerr << "Cannot create a pipe: " << std::strerror(errno) << std::endl;
+        return;
+    }
+    set_nonblocking(wake_pipe[0]);
+    set_nonblocking(wake_pipe[1]);
+    set_nonblocking(listen_fd);
+
+    for(int i=0; i<nb_threads; ++i){
+        std::thread(&solver_server::work, this).detach();
+    }
+
+    std::vector<std::shared_ptr<connection> > connections;
+    while(true){
+        std::vector<pollfd> fds(2);
+        fds[0].fd = listen_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = wake_pipe[0];
+        fds[1].events = POLLIN;
+        for(auto const & conn : connections){
+            pollfd cur;
+            cur.fd = conn->fd;
+            cur.events = conn->has_output() ? POLLIN | POLLOUT : POLLIN;
+            fds.push_back(cur);
+        }
+        for(pollfd & cur : fds) cur.revents = 0;
+        // Wake up regularly to enforce the deadlines
+        poll(fds.data(), fds.size(), 10);
+
+        if(fds[0].revents & POLLIN){
+            int fd = accept(listen_fd, nullptr, nullptr);
+            if(fd >= 0){
+                set_nonblocking(fd);
+                connections.emplace_back(new connection(fd, wake_pipe[1]));
+            }
+        }
+        if(fds[1].revents & POLLIN){
+            char buf[256];
+            while(read(wake_pipe[0], buf, sizeof(buf)) > 0);
+        }
+        for(int i=2; i<int(fds.size()); ++i){
+            std::shared_ptr<connection> conn = connections[i-2];
+            bool lost = false;
+            if(fds[i].revents & (POLLIN | POLLHUP | POLLERR)){
+                char buf[65536];
+                while(true){
+                    ssize_t cur = read(conn->fd, buf, sizeof(buf));
+                    if(cur > 0) conn->input.append(buf, cur);
+                    else if(cur < 0 and errno == EINTR) continue;
+                    else if(cur < 0 and (errno == EAGAIN or errno == EWOULDBLOCK)) break;
+                    else{
+                        lost = true;
+                        break;
+                    }
+                }
+                handle_input(conn);
+            }
+            // Queued replies are sent as far as the socket accepts them, the rest once it is writable again
+            if(not lost and conn->has_output()) lost = not conn->flush();
+            if(lost){
+                // Disconnected: its requests are cancelled
+                {
+                    std::lock_guard<std::mutex> lock(conn->write_mutex);
+                    conn->closed = true;
+                    close(conn->fd);
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                for(auto const & req : pending){
+                    if(req->conn == conn){
+                        req->cancelled = true;
+                        req->stop = true;
+                    }
+                }
+            }
+        }
+        connections.erase(std::remove_if(connections.begin(), connections.end(), [](std::shared_ptr<connection> const & c){ return c->closed; }), connections.end());
+
+        server_clock::time_point now = server_clock::now();
+        std::lock_guard<std::mutex> lock(mutex);
+        for(auto const & req : pending){
+            if(now > req->deadline) req->stop = true;
+        }
+    }
+}
+
+void usage(){
+    std::cerr << "Usage: server --socket PATH [--threads N] [--rule RULE] [--time MS] [--cache FILE]" << std::endl;
+    exit(1);
+}
+
+int main(int argc, char ** argv){
+    search_options options;
+    std::string socket_path;
+    int nb_threads = 1;
+    std::unique_ptr<window_cache> cache;
+    for(int i=1; i<argc; ++i){
+        std::string arg = argv[i];
+        if(i+1 >= argc) usage();
+        std::string val = argv[++i];
+        if(arg == "--socket") socket_path = val;
+        else if(arg == "--threads") nb_threads = std::atoi(val.c_str());
+        else if(arg == "--time") options.max_time_ms = std::atoi(val.c_str());
+        else if(arg == "--rule"){
+            if(not get_rule_from_name(val, options.rule)) usage();
+        }
+        else if(arg == "--cache") cache.reset(new window_cache(val));
+        else usage();
+    }
+    if(socket_path.empty() or nb_threads <= 0) usage();
+
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(socket_path.size() >= sizeof(addr.sun_path)) usage();
+    std::strcpy(addr.sun_path, socket_path.c_str());
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path.c_str());
+    if(listen_fd < 0 or bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 or listen(listen_fd, 64) != 0){
+        std::cerr << "Cannot listen on " << socket_path << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    solver_server server(options, cache.get());
+    server.run(listen_fd, nb_threads);
+    return 0;
+}
+
@@ -0,0 +1,138 @@
+
+#include "detailed/trace.hpp"
+#include "detailed/search.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <set>
+#include <tuple>
+#include <algorithm>
+#include <cstdlib>
+
+// Summary of a search trace written with --trace: where the nodes went, how the bound gap closed, and which decisions were the most expensive
+
+void usage(){
+    std::cerr << "Usage: trace_replay TRACE_FILE [NB_DECISIONS]" << std::endl;
+    exit(1);
+}
+
+int main(int argc, char ** argv){
+    if(argc < 2 or argc > 3) usage();
+    int nb_hottest = argc == 3 ? std::atoi(argv[2]) : 10;
+
+    std::ifstream is(argv[1], std::ios::binary);
+    trace_header header;
+    std::vector<trace_record> records;
+    if(not read_trace(is, header, records)){
+        std::cerr << "Not a trace file" << std::endl;
+        return 1;
+    }
+    if(records.empty()){
+        std::cout << "Empty trace" << std::endl;
+        return 0;
+    }
+
+    auto corrupt = [](){
+        std::cerr << "Corrupt trace" << std::endl;
+        return 1;
+    };
+    if(header.rule < 0 or header.rule > SAVG) return corrupt();
+
+    // Nodes are written after their parent: the tree is rebuilt in one pass, and the subtree sizes in a backward pass
+    int max_id = 0;
+    for(trace_record const & r : records){
+        if(r.node < 0 or r.outcome > TRACE_INFEASIBLE) return corrupt();
+        max_id = std::max(max_id, r.node);
+    }
+    std::vector<int> index(max_id+1, -1);
+    std::vector<int> depth(records.size(), 0), subtree(records.size(), 1);
+    for(int i=0; i<int(records.size()); ++i){
+        int parent = records[i].parent;
+        // Only the root has no parent, and the parent must have been written before
+        if((parent < 0) != (i == 0)) return corrupt();
+        if(parent >= 0 and (parent > max_id or index[parent] < 0 or records[index[parent]].outcome != TRACE_BRANCHED)) return corrupt();
+        index[records[i].node] = i;
+        if(parent >= 0) depth[i] = depth[index[parent]] + 1;
+    }
+    for(int i=records.size()-1; i>0; --i){
+        if(records[i].parent >= 0) subtree[index[records[i].parent]] += subtree[i];
+    }
+
+    long long outcomes[4] = {0, 0, 0, 0};
+    long long flow_us = 0;
+    for(trace_record const & r : records){
+        ++outcomes[r.outcome];
+        flow_us += r.flow_us;
+    }
+    branching_rule rule = static_cast<branching_rule>(header.rule);
+    std::cout << "Rule " << get_rule_name(rule) << ", " << records.size() << " nodes: " << outcomes[TRACE_BRANCHED] << " branched, " << outcomes[TRACE_SOLUTION] << " solutions, ";
+    std::cout << outcomes[TRACE_BOUND_PRUNED] << " pruned by bound, " << outcomes[TRACE_INFEASIBLE] << " infeasible" << std::endl;
+    std::cout << "Time " << records.back().time_us / 1000 << " ms, of which " << flow_us / 1000 << " ms building nodes" << std::endl;
+
+    std::cout << std::endl << "Depth\tNodes\tPruned\tLargest subtree" << std::endl;
+    int max_depth = *std::max_element(depth.begin(), depth.end());
+    for(int d=0; d<=max_depth; ++d){
+        long long nb = 0, pruned = 0;
+        int largest = 0;
+        for(int i=0; i<records.size(); ++i){
+            if(depth[i] != d) continue;
+            ++nb;
+            if(records[i].outcome == TRACE_BOUND_PRUNED or records[i].outcome == TRACE_INFEASIBLE) ++pruned;
+            largest = std::max(largest, subtree[i]);
+        }
+        std::cout << d << "\t" << nb << "\t" << pruned << "\t" << largest << std::endl;
+    }
+
+    // The open nodes are bounded by the bound of their parent until they are evaluated
+    std::cout << std::endl << "Time (ms)\tBest\tLower bound\tGap" << std::endl;
+    std::multiset<int> open_bounds;
+    int best = header.initial_cost;
+    int last_printed_ms = -1, step_ms = std::max(1, records.back().time_us / 1000 / 20);
+    for(int i=0; i<records.size(); ++i){
+        trace_record const & r = records[i];
+        if(r.parent >= 0){
+            auto it = open_bounds.find(records[index[r.parent]].bound);
+            if(it == open_bounds.end()) return corrupt(); // More children than announced
+            open_bounds.erase(it);
+        }
+        bool improved = r.outcome == TRACE_SOLUTION and r.bound < best;
+        if(improved) best = r.bound;
+        if(r.outcome == TRACE_BRANCHED){
+            for(int c=0; c<r.nb_children; ++c) open_bounds.insert(r.bound);
+        }
+
+        int cur_ms = r.time_us / 1000;
+        if(improved or i+1 == records.size() or cur_ms >= last_printed_ms + step_ms){
+            int lower_bound = open_bounds.empty() ? best : std::min(best, *open_bounds.begin());
+            std::cout << cur_ms << "\t" << best << "\t" << lower_bound << "\t" << best - lower_bound << (improved ? "\t*" : "") << std::endl;
+            last_printed_ms = cur_ms;
+        }
+    }
+
+    // Decisions grouped by ordered cell pair and direction
+    typedef std::tuple<int, int, int> decision_key;
+    struct decision_stats{
+        long long count, nodes, flow_us;
+        decision_stats() : count(0), nodes(0), flow_us(0) {}
+    };
+    std::map<decision_key, decision_stats> decisions;
+    for(int i=0; i<records.size(); ++i){
+        if(records[i].parent < 0) continue;
+        decision_stats & cur = decisions[decision_key(records[i].fc, records[i].sc, records[i].direction)];
+        ++cur.count;
+        cur.nodes += subtree[i];
+        cur.flow_us += records[i].flow_us;
+    }
+    std::vector<std::pair<decision_key, decision_stats> > hottest(decisions.begin(), decisions.end());
+    std::sort(hottest.begin(), hottest.end(), [](std::pair<decision_key, decision_stats> const & a, std::pair<decision_key, decision_stats> const & b){ return a.second.nodes > b.second.nodes; });
+    if(hottest.size() > nb_hottest) hottest.resize(nb_hottest);
+
+    std::cout << std::endl << "First cell\tSecond cell\tDirection\tTaken\tSubtree nodes\tBuilding (ms)" << std::endl;
+    for(auto const & d : hottest){
+        std::cout << std::get<0>(d.first) << "\t" << std::get<1>(d.first) << "\t" << (std::get<2>(d.first) ? "y" : "x") << "\t";
+        std::cout << d.second.count << "\t" << d.second.nodes << "\t" << d.second.flow_us / 1000 << std::endl;
+    }
+    return 0;
+}
+
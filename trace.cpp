@@ -0,0 +1,35 @@
+
+#include "detailed/trace.hpp"
+
+#include <cstring>
+
+trace_writer::trace_writer(std::string const & filename, int initial_cost, int rule) : os(filename, std::ios::binary){
+    trace_header header;
+    std::memcpy(header.magic, "AMTR", 4);
+    header.record_size = sizeof(trace_record);
+    header.initial_cost = initial_cost;
+    header.rule = rule;
+    os.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    buffer.reserve(4096);
+}
+
+void trace_writer::flush(){
+    if(buffer.empty()) return;
+    os.write(reinterpret_cast<char const *>(buffer.data()), buffer.size() * sizeof(trace_record));
+    os.flush();
+    buffer.clear();
+}
+
+bool read_trace(std::istream & is, trace_header & header, std::vector<trace_record> & records){
+    if(not is.read(reinterpret_cast<char *>(&header), sizeof(header))) return false;
+    if(std::memcmp(header.magic, "AMTR", 4) != 0 or header.record_size != sizeof(trace_record)) return false;
+
+    records.clear();
+    trace_record cur;
+    while(is.read(reinterpret_cast<char *>(&cur), sizeof(cur))){
+        records.push_back(cur);
+    }
+    // A truncated last record is ignored
+    return true;
+}
+
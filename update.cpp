@@ -0,0 +1,118 @@
+
+#include "detailed/placement_problem.hpp"
+
+#include <cassert>
+
+// The updates reuse the flows of the root problem: each net is detached, modified and attached again
+
+// The wirelength arrays may be shared with copies of the problem: they are copied before being modified
+net_hpwl & placement_problem::update_wirelength(){
+    std::shared_ptr<net_hpwl> updated = std::make_shared<net_hpwl>(*wirelength);
+    wirelength = updated;
+    return *updated;
+}
+
+// Compare with the problem built from scratch, unless the assertions are disabled
+void placement_problem::selfcheck() const{
+#ifndef NDEBUG
+    placement_problem rebuilt(region, cells, nets, fixed_elts);
+    assert(rebuilt.row_height == row_height);
+    assert(rebuilt.is_feasible() == is_feasible());
+    if(not is_feasible()) return;
+    assert(rebuilt.get_cost() == get_cost());
+    std::vector<point> pos = get_positions();
+    assert(rebuilt.get_solution_cost(pos) == get_solution_cost(pos));
+#endif
+}
+
+void placement_problem::set_net(int i, std::vector<pin> const & n){
+    assert(x_constraints.empty() and y_constraints.empty());
+    assert(i >= 0 and i < net_count());
+    detach_net(i);
+    nets[i] = n;
+    attach_net(i);
+    update_wirelength().set_net(i, n);
+    selfcheck();
+}
+
+void placement_problem::set_fixed_pin(int net, int pin_ind, rect r){
+    assert(nets[net][pin_ind].ind == -1);
+    std::vector<pin> n = nets[net];
+    n[pin_ind] = pin(-1, r);
+    set_net(net, n);
+}
+
+void placement_problem::add_net(std::vector<pin> const & n){
+    assert(x_constraints.empty() and y_constraints.empty());
+    nets.push_back(n);
+    net_to_flow_net.push_back(-1);
+    attach_net(net_count()-1);
+    update_wirelength().add_net(n);
+    selfcheck();
+}
+
+void placement_problem::remove_net(int i){
+    assert(x_constraints.empty() and y_constraints.empty());
+    detach_net(i);
+    nets.erase(nets.begin() + i);
+    net_to_flow_net.erase(net_to_flow_net.begin() + i);
+    update_wirelength().remove_net(i);
+    selfcheck();
+}
+
+int placement_problem::add_cell(cell c){
+    assert(x_constraints.empty() and y_constraints.empty());
+    int ind = cell_count();
+    cells.push_back(c);
+    position_constraints.emplace_back(region.xmin, region.ymin, region.xmax - c.width, region.ymax - c.height);
+
+    // Same edges as in the constructor, with the new node just before the nets
+    x_flow.insert_node(ind+1);
+    y_flow.insert_node(ind+1);
+    x_flow.add_edge(ind+1, 0, -region.xmin);
+    x_flow.add_edge(0, ind+1, region.xmax - c.width);
+    y_flow.add_edge(ind+1, 0, -region.ymin);
+    y_flow.add_edge(0, ind+1, region.ymax - c.height);
+
+    detect_rows();
+    update_wirelength().add_cell();
+    selfcheck();
+    return ind;
+}
+
+void placement_problem::remove_cell(int c){
+    assert(x_constraints.empty() and y_constraints.empty());
+    assert(c >= 0 and c < cell_count());
+    for(int i=0; i<net_count(); ++i){
+        std::vector<pin> n;
+        for(pin const p : nets[i]){
+            if(p.ind != c) n.push_back(p);
+        }
+        if(n.size() != nets[i].size()) set_net(i, n);
+    }
+
+    for(MCF_graph * flow : {&x_flow, &y_flow}){
+        flow->remove_edge(c+1, 0);
+        flow->remove_edge(0, c+1);
+        flow->remove_node(c+1);
+    }
+    cells.erase(cells.begin() + c);
+    position_constraints.erase(position_constraints.begin() + c);
+
+    // Renumber the following cells
+    for(auto & n : nets){
+        for(pin & p : n){
+            if(p.ind > c) --p.ind;
+        }
+    }
+    for(flow_net & n : flow_nets){
+        for(pin & p : n.pins){
+            if(p.ind > c) --p.ind;
+        }
+    }
+
+    detect_rows();
+    update_wirelength().remove_cell(c);
+    selfcheck();
+}
+
@@ -0,0 +1,48 @@
+
+#include "detailed/window.hpp"
+
+bool read_window(std::istream & is, window & w){
+    int bxmn, bymn, bxmx, bymx;
+    is >> bxmn >> bymn >> bxmx >> bymx;
+    w.bounding_box = rect(bxmn, bymn, bxmx, bymx);
+
+    int nb_cells, nb_nets, nb_fixeds;
+    is >> nb_cells;
+    w.cells.clear();
+    for(int i=0; i<nb_cells and is; ++i){
+        int width, height, x_pitch, y_pitch;
+        is >> width >> height >> x_pitch >> y_pitch;
+        w.cells.emplace_back(width, height, x_pitch, y_pitch);
+    }
+
+    is >> nb_fixeds;
+    w.fixed.clear();
+    for(int i=0; i<nb_fixeds and is; ++i){
+        int xmn, ymn, xmx, ymx;
+        is >> xmn >> ymn >> xmx >> ymx;
+        w.fixed.emplace_back(xmn, ymn, xmx, ymx);
+    }
+
+    is >> nb_nets;
+    w.nets.clear();
+    for(int i=0; i<nb_nets and is; ++i){
+        w.nets.emplace_back();
+        int nb_pins;
+        is >> nb_pins;
+        for(int j=0; j<nb_pins and is; ++j){
+            int xmn, ymn, xmx, ymx, ind;
+            is >> ind >> xmn >> ymn >> xmx >> ymx;
+            if(ind < -1 or ind >= nb_cells) return false;
+            w.nets.back().emplace_back(ind, rect(xmn, ymn, xmx, ymx));
+        }
+    }
+
+    w.positions.clear();
+    for(int i=0; i<nb_cells and is; ++i){
+        int x, y;
+        is >> x >> y;
+        w.positions.emplace_back(x,y);
+    }
+    return bool(is);
+}
+
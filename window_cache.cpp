@@ -0,0 +1,184 @@
+
+#include "detailed/window_cache.hpp"
+
+#include <cassert>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace{
+    std::size_t hash_combine(std::size_t seed, std::size_t v){
+        return seed ^ (v + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+    }
+    std::size_t hash_rect(std::size_t seed, rect r){
+        seed = hash_combine(seed, r.xmin);
+        seed = hash_combine(seed, r.ymin);
+        seed = hash_combine(seed, r.xmax);
+        return hash_combine(seed, r.ymax);
+    }
+    rect translated(rect r, int dx, int dy){
+        return rect(r.xmin+dx, r.ymin+dy, r.xmax+dx, r.ymax+dy);
+    }
+}
+
+std::size_t window_cache::key_hash::operator()(std::vector<int> const & key) const{
+    std::size_t ret = key.size();
+    for(int v : key) ret = hash_combine(ret, v);
+    return ret;
+}
+
+window_cache::canonical_form window_cache::canonicalize(window const & w){
+    canonical_form ret;
+    ret.dx = -w.bounding_box.xmin;
+    ret.dy = -w.bounding_box.ymin;
+    int cell_cnt = w.cells.size();
+
+    // Color refinement: cells are colored by their dimensions, then by the colors of their neighbours through the nets
+    std::vector<std::size_t> colors(cell_cnt);
+    for(int c=0; c<cell_cnt; ++c){
+        cell const C = w.cells[c];
+        colors[c] = hash_rect(0, rect(C.width, C.height, C.x_pitch, C.y_pitch));
+    }
+    int color_cnt = 0;
+    for(int round=0; round<cell_cnt; ++round){
+        std::vector<std::size_t> net_colors;
+        for(auto const & n : w.nets){
+            std::vector<std::size_t> pin_colors;
+            for(pin const p : n){
+                std::size_t pc = p.ind >= 0 ? hash_rect(colors[p.ind], p) : hash_rect(1, translated(p, ret.dx, ret.dy));
+                pin_colors.push_back(pc);
+            }
+            std::sort(pin_colors.begin(), pin_colors.end());
+            std::size_t nc = pin_colors.size();
+            for(std::size_t pc : pin_colors) nc = hash_combine(nc, pc);
+            net_colors.push_back(nc);
+        }
+
+        std::vector<std::vector<std::size_t> > cell_neighbours(cell_cnt);
+        for(int i=0; i<w.nets.size(); ++i){
+            for(pin const p : w.nets[i]){
+                if(p.ind >= 0) cell_neighbours[p.ind].push_back(hash_rect(net_colors[i], p));
+            }
+        }
+        for(int c=0; c<cell_cnt; ++c){
+            std::sort(cell_neighbours[c].begin(), cell_neighbours[c].end());
+            for(std::size_t nc : cell_neighbours[c]) colors[c] = hash_combine(colors[c], nc);
+        }
+
+        std::vector<std::size_t> distinct = colors;
+        std::sort(distinct.begin(), distinct.end());
+        int new_color_cnt = std::unique(distinct.begin(), distinct.end()) - distinct.begin();
+        if(new_color_cnt == color_cnt) break;
+        color_cnt = new_color_cnt;
+    }
+
+    for(int c=0; c<cell_cnt; ++c) ret.order.push_back(c);
+    std::stable_sort(ret.order.begin(), ret.order.end(), [&](int a, int b){ return colors[a] < colors[b]; });
+    std::vector<int> new_index(cell_cnt);
+    for(int c=0; c<cell_cnt; ++c) new_index[ret.order[c]] = c;
+
+    // Serialize the translated window
+    std::vector<int> & key = ret.key;
+    rect box = translated(w.bounding_box, ret.dx, ret.dy);
+    key.insert(key.end(), {box.xmax, box.ymax, cell_cnt});
+    for(int c : ret.order){
+        cell const C = w.cells[c];
+        key.insert(key.end(), {C.width, C.height, C.x_pitch, C.y_pitch});
+    }
+
+    // Same filtering as placement_problem
+    std::vector<std::vector<int> > fixed_keys;
+    for(rect const R : w.fixed){
+        rect cur = rect::intersection(translated(R, ret.dx, ret.dy), box);
+        if(cur.get_area() > 0) fixed_keys.push_back(std::vector<int>({cur.xmin, cur.ymin, cur.xmax, cur.ymax}));
+    }
+    std::sort(fixed_keys.begin(), fixed_keys.end());
+    key.push_back(fixed_keys.size());
+    for(auto const & f : fixed_keys) key.insert(key.end(), f.begin(), f.end());
+
+    std::vector<std::vector<int> > net_keys;
+    for(auto const & n : w.nets){
+        std::vector<std::vector<int> > pin_keys;
+        for(pin const p : n){
+            rect r = p.ind >= 0 ? rect(p) : translated(p, ret.dx, ret.dy);
+            pin_keys.push_back(std::vector<int>({p.ind >= 0 ? new_index[p.ind] : -1, r.xmin, r.ymin, r.xmax, r.ymax}));
+        }
+        std::sort(pin_keys.begin(), pin_keys.end());
+        net_keys.emplace_back(1, pin_keys.size());
+        for(auto const & p : pin_keys) net_keys.back().insert(net_keys.back().end(), p.begin(), p.end());
+    }
+    std::sort(net_keys.begin(), net_keys.end());
+    key.push_back(net_keys.size());
+    for(auto const & n : net_keys) key.insert(key.end(), n.begin(), n.end());
+
+    return ret;
+}
+
+bool window_cache::lookup(window const & w, std::vector<point> & positions) const{
+    canonical_form form = canonicalize(w);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = solutions.find(form.key);
+    if(it == solutions.end() or it->second.positions.size() != w.cells.size()) return false;
+
+    positions.assign(w.cells.size(), point(0, 0));
+    for(int i=0; i<form.order.size(); ++i){
+        point p = it->second.positions[i];
+        positions[form.order[i]] = point(p.x - form.dx, p.y - form.dy);
+    }
+    return true;
+}
+
+void window_cache::insert(window const & w, std::vector<point> const & positions, int cost){
+    assert(positions.size() == w.cells.size());
+    canonical_form form = canonicalize(w);
+    entry cur;
+    cur.cost = cost;
+    for(int c : form.order){
+        cur.positions.emplace_back(positions[c].x + form.dx, positions[c].y + form.dy);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if(not solutions.emplace(form.key, cur).second) return;
+    if(filename.empty()) return;
+
+    // One write per entry, so that concurrent solvers may share the file
+    std::ostringstream line;
+    line << form.key.size();
+    for(int v : form.key) line << " " << v;
+    line << " " << cost << " " << cur.positions.size();
+    for(point p : cur.positions) line << " " << p.x << " " << p.y;
+    line << "\n";
+    std::ofstream f(filename, std::ios::app);
+    f << line.str() << std::flush;
+}
+
+void window_cache::load(){
+    std::ifstream f(filename);
+    std::string line;
+    while(std::getline(f, line)){
+        std::istringstream is(line);
+        std::size_t key_size, pos_size;
+        if(not (is >> key_size)) continue;
+        std::vector<int> key(key_size);
+        for(int & v : key) is >> v;
+        entry cur;
+        is >> cur.cost >> pos_size;
+        for(std::size_t i=0; i<pos_size and is; ++i){
+            int x, y;
+            is >> x >> y;
+            cur.positions.emplace_back(x, y);
+        }
+        // Ignore truncated entries
+        if(is and cur.positions.size() == pos_size) solutions.emplace(key, cur);
+    }
+}
+
+std::size_t window_cache::size() const{
+    std::lock_guard<std::mutex> lock(mutex);
+    return solutions.size();
+}
+
+window_cache::window_cache(std::string const & persistent_file) : filename(persistent_file){
+    if(not filename.empty()) load();
+}
+